@@ -37,6 +37,18 @@ void Hilltop::Console::DoublePixelBufferedConsole::clear(ConsoleColor color) {
     buffer.assign(buffer.size(), value);
 }
 
+uint8_t *Hilltop::Console::DoublePixelBufferedConsole::data() {
+    return buffer.data();
+}
+
+const uint8_t *Hilltop::Console::DoublePixelBufferedConsole::data() const {
+    return buffer.data();
+}
+
+size_t Hilltop::Console::DoublePixelBufferedConsole::size() const {
+    return buffer.size();
+}
+
 void Hilltop::Console::DoublePixelBufferedConsole::commit(Console &buffer) const {
     for (unsigned short i = 0; i < height / 2; i++) {
         for (unsigned short j = 0; j < width; j++) {
@@ -23,6 +23,11 @@ public:
     void set(unsigned short x, unsigned short y, ConsoleColor color);
     void clear(ConsoleColor color);
 
+    // the pixels themselves, packed two to a byte
+    uint8_t *data();
+    const uint8_t *data() const;
+    size_t size() const;
+
     void commit(Console &buffer) const;
 };
 
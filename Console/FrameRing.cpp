@@ -0,0 +1,183 @@
+#include "FrameRing.h"
+#include <cstring>
+#include <stdexcept>
+
+
+namespace Hilltop {
+namespace Console {
+
+// shorter repeats are cheaper to store as literals
+static const size_t MIN_RUN = 3;
+
+static uint8_t *writeVarint(uint8_t *out, size_t value) {
+    while (value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+static const uint8_t *readVarint(const uint8_t *in, size_t &value) {
+    value = 0;
+    int shift = 0;
+    uint8_t b;
+    do {
+        b = *in++;
+        value |= (size_t)(b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    return in;
+}
+
+FrameRing::FrameRing(unsigned short width, unsigned short height, size_t memoryBudget)
+    : data(memoryBudget), frames(MAX_FRAMES), previous(width, height), decoded(width, height) {
+    if (memoryBudget < getMaxEncodedSize())
+        throw std::runtime_error("The frame ring can't hold a single frame");
+}
+
+FrameRing::frame_t &FrameRing::at(uint64_t frame) {
+    return frames[frame % MAX_FRAMES];
+}
+
+const FrameRing::frame_t &FrameRing::at(uint64_t frame) const {
+    return frames[frame % MAX_FRAMES];
+}
+
+size_t FrameRing::getMaxEncodedSize() const {
+    // short runs broken up by literals, each needing its own header, are the worst case
+    return previous.size() * 2 + 16;
+}
+
+void FrameRing::dropOldest() {
+    first++;
+    // deltas can't be decoded without the keyframe before them
+    while (first < next && !at(first).isKey)
+        first++;
+}
+
+size_t FrameRing::encode(const uint8_t *canvas, const uint8_t *reference, uint8_t *out) const {
+    const size_t size = previous.size();
+    uint8_t *const begin = out;
+
+    auto delta = [canvas, reference](size_t i)->uint8_t {
+        return reference ? canvas[i] ^ reference[i] : canvas[i];
+    };
+
+    size_t literal = 0;
+    size_t i = 0;
+    while (i < size) {
+        const uint8_t value = delta(i);
+        size_t run = 1;
+        while (i + run < size && delta(i + run) == value)
+            run++;
+
+        if (run >= MIN_RUN) {
+            if (literal < i) {
+                out = writeVarint(out, (i - literal) << 1);
+                for (size_t j = literal; j < i; j++)
+                    *out++ = delta(j);
+            }
+            out = writeVarint(out, (run << 1) | 1);
+            *out++ = value;
+            literal = i + run;
+        }
+        i += run;
+    }
+
+    if (literal < size) {
+        out = writeVarint(out, (size - literal) << 1);
+        for (size_t j = literal; j < size; j++)
+            *out++ = delta(j);
+    }
+
+    return out - begin;
+}
+
+uint64_t FrameRing::push(const DoublePixelBufferedConsole &canvas) {
+    if (canvas.size() != previous.size())
+        throw std::runtime_error("The frame doesn't match the size of the frame ring");
+
+    const size_t reserve = getMaxEncodedSize();
+    if (writePos + reserve > data.size()) {
+        // the end of the buffer is skipped, anything still stored there is the oldest
+        while (first < next && at(first).offset >= writePos)
+            dropOldest();
+        writePos = 0;
+    }
+
+    // frames are written in order, so the ones in the way are always the oldest
+    while (first < next && (next - first >= MAX_FRAMES ||
+        (at(first).offset < writePos + reserve && at(first).offset + at(first).size > writePos)))
+        dropOldest();
+
+    frame_t &frame = at(next);
+    frame.offset = writePos;
+    frame.isKey = first == next || sinceKey + 1 >= KEYFRAME_EVERY;
+    frame.size = encode(canvas.data(), frame.isKey ? nullptr : previous.data(), &data[writePos]);
+
+    sinceKey = frame.isKey ? 0 : sinceKey + 1;
+    writePos += frame.size;
+    std::memcpy(previous.data(), canvas.data(), canvas.size());
+    return next++;
+}
+
+bool FrameRing::contains(uint64_t frame) const {
+    return frame >= first && frame < next;
+}
+
+uint64_t FrameRing::getFirst() const {
+    return first;
+}
+
+uint64_t FrameRing::getNext() const {
+    return next;
+}
+
+void FrameRing::apply(const frame_t &frame) {
+    const uint8_t *in = &data[frame.offset];
+    const uint8_t *const end = in + frame.size;
+    uint8_t *out = decoded.data();
+
+    if (frame.isKey)
+        std::memset(out, 0, decoded.size());
+
+    while (in < end) {
+        size_t control;
+        in = readVarint(in, control);
+        const size_t count = control >> 1;
+        if (control & 1) {
+            const uint8_t value = *in++;
+            for (size_t i = 0; i < count; i++)
+                *out++ ^= value;
+        } else {
+            for (size_t i = 0; i < count; i++)
+                *out++ ^= *in++;
+        }
+    }
+}
+
+const DoublePixelBufferedConsole *FrameRing::get(uint64_t frame) {
+    if (!contains(frame))
+        return nullptr;
+
+    uint64_t key = frame;
+    while (!at(key).isKey)
+        key--;
+
+    // carry on from the last decoded frame when it's on the way, playback mostly asks for the
+    // frame right after it
+    uint64_t from = key;
+    if (hasDecoded && decodedFrame >= key && decodedFrame <= frame)
+        from = decodedFrame + 1;
+
+    for (uint64_t i = from; i <= frame; i++)
+        apply(at(i));
+
+    decodedFrame = frame;
+    hasDecoded = true;
+    return &decoded;
+}
+
+}
+}
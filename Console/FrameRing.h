@@ -0,0 +1,61 @@
+#pragma once
+
+#include "DoublePixelBufferedConsole.h"
+#include <vector>
+
+
+namespace Hilltop {
+namespace Console {
+
+// Keeps the most recent frames drawn to a canvas in a fixed amount of memory. Every frame is
+// stored as the run-length encoded XOR against the one before it, with a full frame every
+// KEYFRAME_EVERY frames so playback can start without going back to the oldest one. Nothing is
+// allocated after construction, the oldest frames are dropped to make room for new ones.
+class FrameRing {
+public:
+    static const size_t KEYFRAME_EVERY = 64;
+    static const size_t MAX_FRAMES = 8192;
+
+    FrameRing(unsigned short width, unsigned short height, size_t memoryBudget);
+
+    // stores a copy of canvas, returns its frame number
+    uint64_t push(const DoublePixelBufferedConsole &canvas);
+
+    bool contains(uint64_t frame) const;
+    uint64_t getFirst() const;
+    // the number the next pushed frame will get
+    uint64_t getNext() const;
+
+    // rebuilds a stored frame, the result is valid until the next call, nullptr if it was dropped
+    const DoublePixelBufferedConsole *get(uint64_t frame);
+
+private:
+    struct frame_t {
+        size_t offset;
+        size_t size;
+        bool isKey;
+    };
+
+    std::vector<uint8_t> data;
+    std::vector<frame_t> frames;
+    uint64_t first = 0;
+    uint64_t next = 0;
+    size_t writePos = 0;
+    size_t sinceKey = 0;
+
+    // the last pushed frame, which the next one is encoded against
+    DoublePixelBufferedConsole previous;
+    DoublePixelBufferedConsole decoded;
+    uint64_t decodedFrame = 0;
+    bool hasDecoded = false;
+
+    frame_t &at(uint64_t frame);
+    const frame_t &at(uint64_t frame) const;
+    size_t getMaxEncodedSize() const;
+    void dropOldest();
+    size_t encode(const uint8_t *canvas, const uint8_t *reference, uint8_t *out) const;
+    void apply(const frame_t &frame);
+};
+
+}
+}
@@ -0,0 +1,45 @@
+#include "MemoryConsole.h"
+
+
+namespace Hilltop {
+namespace Console {
+
+MemoryConsole::MemoryConsole(unsigned short width, unsigned short height)
+    : BufferedConsole(width, height) {}
+
+std::shared_ptr<MemoryConsole> MemoryConsole::create(unsigned short width, unsigned short height) {
+    return std::shared_ptr<MemoryConsole>(new MemoryConsole(width, height));
+}
+
+BufferedConsole::pixel_t MemoryConsole::get(unsigned short x, unsigned short y) const {
+    if (x >= height || y >= width)
+        return pixel_t();
+
+    return buffer[x * width + y];
+}
+
+void MemoryConsole::set(unsigned short x, unsigned short y, wchar_t ch, ConsoleColor color) {
+    BufferedConsole::set(x, y, ch, color);
+}
+
+void MemoryConsole::set(unsigned short x, unsigned short y, wchar_t ch, ConsoleColor color,
+    ConsoleColorType colorMask) {
+    if (x >= height || y >= width)
+        return;
+
+    pixel_t &pixel = buffer[x * width + y];
+    pixel.ch = ch;
+    pixel.color = calc_masked_color(pixel.color, color, colorMask);
+}
+
+void MemoryConsole::copyTo(BufferedConsole &console) const {
+    for (unsigned short i = 0; i < height; i++) {
+        for (unsigned short j = 0; j < width; j++) {
+            const pixel_t &pixel = buffer[i * width + j];
+            console.set(i, j, pixel.ch, pixel.color);
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "BufferedConsole.h"
+#include <vector>
+
+
+namespace Hilltop {
+namespace Console {
+
+// A console that only exists in memory, for drawing a frame somewhere other than where it ends up.
+class MemoryConsole : public BufferedConsole {
+private:
+    std::vector<pixel_t> buffer = std::vector<pixel_t>(width * height);
+
+protected:
+    MemoryConsole(unsigned short width, unsigned short height);
+
+public:
+    static std::shared_ptr<MemoryConsole> create(unsigned short width, unsigned short height);
+
+    virtual pixel_t get(unsigned short x, unsigned short y) const override;
+    virtual void set(unsigned short x, unsigned short y, wchar_t ch, ConsoleColor color) override;
+    virtual void set(unsigned short x, unsigned short y, wchar_t ch, ConsoleColor color,
+        ConsoleColorType colorMask) override;
+
+    // draws everything in this console onto another one the same size
+    void copyTo(BufferedConsole &console) const;
+};
+
+}
+}
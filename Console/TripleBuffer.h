@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+
+
+namespace Hilltop {
+namespace Console {
+
+// Hands the latest of a stream of frames from one thread to another without either of them ever
+// waiting. The writer draws into getBack() and publishes it, the reader calls update() and shows
+// getFront(). Frames the reader was too slow to pick up are simply drawn over.
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer(T first, T second, T third) : slots{ first, second, third } {}
+
+    T &getBack() {
+        return slots[back];
+    }
+
+    void publish() {
+        back = state.exchange(back | FRESH) & INDEX_MASK;
+    }
+
+    // swaps in the last published frame, returns false if nothing was published since
+    bool update() {
+        if (!(state.load() & FRESH))
+            return false;
+        front = state.exchange(front) & INDEX_MASK;
+        return true;
+    }
+
+    T &getFront() {
+        return slots[front];
+    }
+
+private:
+    static const int INDEX_MASK = 3;
+    static const int FRESH = 4;
+
+    T slots[3];
+    int back = 0;
+    int front = 1;
+    // the slot in the middle, plus FRESH if the writer put it there after the reader's last update
+    std::atomic<int> state{ 2 };
+};
+
+}
+}
@@ -13,6 +13,15 @@ std::shared_ptr<ArmorDrop> ArmorDrop::create() {
     return std::shared_ptr<ArmorDrop>(new ArmorDrop());
 }
 
+std::shared_ptr<Entity> ArmorDrop::clone() {
+    return std::shared_ptr<ArmorDrop>(new ArmorDrop(*this));
+}
+
+bool ArmorDrop::copyFrom(const Entity &other) {
+    *this = static_cast<const ArmorDrop &>(other);
+    return true;
+}
+
 void ArmorDrop::handleTank(TankMatch *match, Tank &tank) {
     tank.armor = std::min(tank.maxArmor, tank.armor + ARMOR);
 }
@@ -0,0 +1,137 @@
+#include "Game/Base64Buffer.h"
+#include <cstring>
+
+
+namespace Hilltop {
+namespace Game {
+
+static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int decodeChar(int ch) {
+    if (ch >= 'A' && ch <= 'Z')
+        return ch - 'A';
+    if (ch >= 'a' && ch <= 'z')
+        return ch - 'a' + 26;
+    if (ch >= '0' && ch <= '9')
+        return ch - '0' + 52;
+    if (ch == '+')
+        return 62;
+    if (ch == '/')
+        return 63;
+    return -1;
+}
+
+Base64Encoder::Base64Encoder(std::ostream &out) : out(out) {
+    setp(input, input + BUFFER_SIZE);
+}
+
+Base64Encoder::~Base64Encoder() {
+    finish();
+}
+
+void Base64Encoder::finish() {
+    if (finished)
+        return;
+    encode(true);
+    finished = true;
+}
+
+Base64Encoder::int_type Base64Encoder::overflow(int_type ch) {
+    if (finished)
+        return traits_type::eof();
+
+    encode(false);
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int Base64Encoder::sync() {
+    if (!finished)
+        encode(false);
+    out.flush();
+    return out ? 0 : -1;
+}
+
+void Base64Encoder::encode(bool final) {
+    const int size = (int)(pptr() - pbase());
+    const int whole = size - size % 3;
+
+    char *o = output;
+    for (int i = 0; i < whole; i += 3) {
+        const unsigned int group = ((unsigned char)input[i] << 16) |
+            ((unsigned char)input[i + 1] << 8) | (unsigned char)input[i + 2];
+        *o++ = ALPHABET[(group >> 18) & 0x3F];
+        *o++ = ALPHABET[(group >> 12) & 0x3F];
+        *o++ = ALPHABET[(group >> 6) & 0x3F];
+        *o++ = ALPHABET[group & 0x3F];
+    }
+
+    const int left = size - whole;
+    if (final && left > 0) {
+        unsigned int group = (unsigned char)input[whole] << 16;
+        if (left > 1)
+            group |= (unsigned char)input[whole + 1] << 8;
+        *o++ = ALPHABET[(group >> 18) & 0x3F];
+        *o++ = ALPHABET[(group >> 12) & 0x3F];
+        *o++ = left > 1 ? ALPHABET[(group >> 6) & 0x3F] : '=';
+        *o++ = '=';
+    }
+    out.write(output, o - output);
+
+    // a partial group waits for the rest of its bytes
+    std::memmove(input, input + whole, final ? 0 : left);
+    setp(input, input + BUFFER_SIZE);
+    pbump(final ? 0 : left);
+}
+
+Base64Decoder::Base64Decoder(std::istream &in) : in(in) {
+    setg(output, output, output);
+}
+
+Base64Decoder::int_type Base64Decoder::underflow() {
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+    if (ended)
+        return traits_type::eof();
+
+    std::streambuf *source = in.rdbuf();
+    char *o = output;
+    unsigned int group = 0;
+    int count = 0;
+    while (o + 3 <= output + BUFFER_SIZE) {
+        const int value = decodeChar(source->sgetc());
+        if (value < 0) {
+            ended = true;
+            break;
+        }
+        source->sbumpc();
+
+        group = (group << 6) | value;
+        if (++count == 4) {
+            *o++ = (char)(group >> 16);
+            *o++ = (char)(group >> 8);
+            *o++ = (char)group;
+            group = 0;
+            count = 0;
+        }
+    }
+
+    // the padding was left out, so whatever is left of the last group is exact
+    if (count >= 2) {
+        group <<= 6 * (4 - count);
+        *o++ = (char)(group >> 16);
+        if (count == 3)
+            *o++ = (char)(group >> 8);
+    }
+
+    setg(output, output, o);
+    if (o == output)
+        return traits_type::eof();
+    return traits_type::to_int_type(*gptr());
+}
+
+}
+}
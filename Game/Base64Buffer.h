@@ -0,0 +1,51 @@
+#pragma once
+
+#include <iostream>
+
+
+namespace Hilltop {
+namespace Game {
+
+// Stream buffers that base64-encode everything written through them into another stream, or
+// decode base64 read from another stream, through a buffer of fixed size.
+class Base64Encoder : public std::streambuf {
+public:
+    static const int BUFFER_SIZE = 3 * 1024;
+
+    Base64Encoder(std::ostream &out);
+    virtual ~Base64Encoder();
+
+    // writes out the last partial group with its padding, nothing can be written after this
+    void finish();
+
+protected:
+    virtual int_type overflow(int_type ch) override;
+    virtual int sync() override;
+
+private:
+    std::ostream &out;
+    char input[BUFFER_SIZE];
+    char output[BUFFER_SIZE / 3 * 4];
+    bool finished = false;
+
+    void encode(bool final);
+};
+
+class Base64Decoder : public std::streambuf {
+public:
+    static const int BUFFER_SIZE = 3 * 1024;
+
+    // stops at the padding or at the first character that isn't base64, leaving it unread
+    Base64Decoder(std::istream &in);
+
+protected:
+    virtual int_type underflow() override;
+
+private:
+    std::istream &in;
+    char output[BUFFER_SIZE];
+    bool ended = false;
+};
+
+}
+}
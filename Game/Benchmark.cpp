@@ -0,0 +1,297 @@
+#include "Game/Benchmark.h"
+#include "Console/MemoryConsole.h"
+#include "Game/Explosion.h"
+#include "Game/Instrumentation.h"
+#include "Game/MatchFile.h"
+#include "Game/MatchSetup.h"
+#include "Game/TankController.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+
+namespace Hilltop {
+namespace Game {
+
+// hard, the strongest bot that doesn't search through forks of the match
+static const int BOT_DIFFICULTY = 2;
+static const int SETTLE_TICKS = 20 * 60 * 5;
+static const int BULLET_RAIN_SECONDS = 20;
+static const int EXPLOSION_SIZES[] = { 5, 10, 20 };
+// how far into its flight the volley that is saved and loaded is
+static const int VOLLEY_TICKS = 15;
+
+static std::shared_ptr<TankMatch> buildMatch(bool bots) {
+    MatchSetup setup;
+    setup.seed = Benchmark::SEED;
+    for (int i = 0; i < 2; i++) {
+        MatchSetup::player_t player;
+        player.team = i + 1;
+        player.color = i == 0 ? Console::RED : Console::BLUE;
+        player.isHuman = !bots;
+        player.botDifficulty = BOT_DIFFICULTY;
+        setup.players.push_back(player);
+    }
+
+    std::shared_ptr<TankMatch> match = setup.build();
+    match->headless = true;
+    match->settle(SETTLE_TICKS);
+    return match;
+}
+
+static std::shared_ptr<Weapon> findWeapon(const std::string &name) {
+    for (const std::shared_ptr<Weapon> &weapon : TankMatch::weapons)
+        if (weapon->name == name)
+            return weapon;
+    throw std::runtime_error("There is no weapon called " + name);
+}
+
+// fires the weapon from the current player's tank, then lets the shot play out until things stop
+// moving, or for the given number of seconds
+static std::function<void()> prepareVolley(const std::shared_ptr<TankMatch> &base,
+    const std::string &weaponName, int seconds = 0) {
+    std::shared_ptr<Weapon> weapon = findWeapon(weaponName);
+    std::shared_ptr<TankMatch> match = base->fork();
+    return [match, weapon, seconds]() {
+        weapon->fire(*match, match->currentPlayer);
+        match->isAiming = false;
+        if (seconds > 0) {
+            for (int i = 0; i < seconds * match->ticksPerSecond; i++)
+                match->tick();
+        } else {
+            match->settle(SETTLE_TICKS);
+        }
+    };
+}
+
+// fills the upper half of the sky with dirt, across the whole map, and drops it until it has all
+// landed, without the ticks in between
+static std::function<void()> prepareCollapse(const std::shared_ptr<TankMatch> &base) {
+    std::shared_ptr<TankMatch> match = base->fork();
+
+    int top = match->height;
+    for (int x = 0; x < match->height; x++)
+        for (int y = 0; y < match->width; y++)
+            if (match->get(x, y) != TankMatch::AIR)
+                top = std::min(top, x);
+
+    for (int x = 0; x < top / 2; x++)
+        for (int y = 0; y < match->width; y++)
+            match->set(x, y, TankMatch::DIRT);
+
+    return [match]() {
+        while (match->land.doPhysics()) {}
+    };
+}
+
+// an explosion on the surface in the middle of the map, for as long as it lasts
+static std::function<void()> prepareExplosion(const std::shared_ptr<TankMatch> &base, int size) {
+    std::shared_ptr<TankMatch> match = base->fork();
+
+    const int y = match->width / 2;
+    int x = 0;
+    while (x < match->height - 1 && match->get(x, y) == TankMatch::AIR)
+        x++;
+
+    std::shared_ptr<Explosion> explosion = Explosion::create(size);
+    explosion->position = Vector2((float)x, (float)y);
+    explosion->willDestroyLand = true;
+    match->addEntity(*explosion);
+
+    return [match, explosion]() {
+        do {
+            match->tick();
+        } while (!match->entityChanges.empty() || std::find(match->entities.begin(),
+            match->entities.end(), explosion) != match->entities.end());
+    };
+}
+
+// the current player's turn, from the start until the bot fires
+static std::function<void()> prepareBotTurn(const std::shared_ptr<TankMatch> &base) {
+    std::shared_ptr<TankMatch> match = base->fork();
+    return [match]() {
+        TankController &player = *match->players[match->currentPlayer];
+        while (!TankController::applyAI(match.get(), player)) {
+            // the plan is worked out on other threads, waiting for it is part of the turn
+            while (player.isBotThinking())
+                std::this_thread::yield();
+            match->tick();
+        }
+    };
+}
+
+// a round trip through a save has to leave the match exactly as it was
+static void checkSameHash(const TankMatch &expected, const TankMatch &actual, const char *what) {
+    if (expected.getHash() != actual.getHash())
+        throw std::runtime_error(std::string("The ") + what + " match differs from the original");
+}
+
+std::vector<Benchmark::scenario_t> Benchmark::getScenarios() {
+    const std::shared_ptr<TankMatch> match = buildMatch(false);
+    const std::shared_ptr<TankMatch> botMatch = buildMatch(true);
+    const std::shared_ptr<TankMatch> idle = match->fork();
+    const std::shared_ptr<TankMatch> volley = match->fork();
+    findWeapon("Five Missiles")->fire(*volley, volley->currentPlayer);
+    volley->isAiming = false;
+    for (int i = 0; i < VOLLEY_TICKS; i++)
+        volley->tick();
+    const std::shared_ptr<TankMatch> view = std::make_shared<TankMatch>(match->width, match->height);
+    const std::shared_ptr<Console::MemoryConsole> console =
+        Console::MemoryConsole::create(match->width, match->height / 2);
+
+    std::vector<scenario_t> ret;
+    ret.push_back({ "idle aim tick", [idle]() {
+        return [idle]() {
+            idle->tick();
+        };
+    } });
+    // what the game loop does every tick, besides drawing, it shouldn't allocate at all once warm
+    ret.push_back({ "idle tick and view copy", [idle, view]() {
+        return [idle, view]() {
+            idle->tick();
+            idle->copyForDrawing(*view);
+        };
+    } });
+    ret.push_back({ "five missiles", [match]() {
+        return prepareVolley(match, "Five Missiles");
+    } });
+    ret.push_back({ "particle bomb", [match]() {
+        return prepareVolley(match, "Particle Bomb");
+    } });
+    ret.push_back({ "bullet rain 20s", [match]() {
+        return prepareVolley(match, "Bullet Rain", BULLET_RAIN_SECONDS);
+    } });
+    ret.push_back({ "minigun", [match]() {
+        return prepareVolley(match, "Minigun");
+    } });
+    ret.push_back({ "land collapse", [match]() {
+        return prepareCollapse(match);
+    } });
+    ret.push_back({ "draw and commit", [match, console]() {
+        return [match, console]() {
+            match->draw(*console);
+        };
+    } });
+    for (int size : EXPLOSION_SIZES) {
+        ret.push_back({ "explosion size " + std::to_string(size), [match, size]() {
+            return prepareExplosion(match, size);
+        } });
+    }
+    ret.push_back({ "bot turn", [botMatch]() {
+        return prepareBotTurn(botMatch);
+    } });
+    // a volley in flight, so there's more than the land and the tanks to get right
+    ret.push_back({ "save and load", [volley]() {
+        return [volley]() {
+            std::stringstream stream;
+            MatchFile::write(stream, volley);
+            std::shared_ptr<TankMatch> loaded = MatchFile::read(stream);
+            loaded->headless = true;
+            checkSameHash(*volley, *loaded, "loaded");
+            // and it must play on the same, from a copy so every op saves the same match
+            std::shared_ptr<TankMatch> original = volley->fork();
+            original->tick();
+            loaded->tick();
+            checkSameHash(*original, *loaded, "loaded and ticked");
+        };
+    } });
+    return ret;
+}
+
+Benchmark::result_t Benchmark::measure(const scenario_t &scenario) {
+    typedef std::chrono::steady_clock clock_t;
+
+    result_t ret;
+    ret.name = scenario.name;
+
+    // warms up the caches, and anything built on first use
+    scenario.prepare()();
+
+    clock_t::duration total = clock_t::duration::zero();
+    Instrumentation::counters_t counted;
+    while (ret.ops < MIN_OPS || total < std::chrono::milliseconds(MIN_MILLISECONDS)) {
+        std::function<void()> op = scenario.prepare();
+
+        const Instrumentation::counters_t before = Instrumentation::getTotals();
+        const clock_t::time_point start = clock_t::now();
+        op();
+        total += clock_t::now() - start;
+        const Instrumentation::counters_t done = Instrumentation::getTotals() - before;
+
+        counted.allocations += done.allocations;
+        counted.bytes += done.bytes;
+        counted.entitiesAdded += done.entitiesAdded;
+        counted.entitiesRemoved += done.entitiesRemoved;
+        ret.ops++;
+    }
+
+    ret.nsPerOp = std::chrono::duration<double, std::nano>(total).count() / ret.ops;
+    ret.allocationsPerOp = (double)counted.allocations / ret.ops;
+    ret.bytesPerOp = (double)counted.bytes / ret.ops;
+    ret.entitiesAddedPerOp = (double)counted.entitiesAdded / ret.ops;
+    ret.entitiesRemovedPerOp = (double)counted.entitiesRemoved / ret.ops;
+    return ret;
+}
+
+std::vector<Benchmark::result_t> Benchmark::run(const std::string &filter) {
+    std::vector<result_t> ret;
+    for (const scenario_t &scenario : getScenarios())
+        if (scenario.name.find(filter) != std::string::npos)
+            ret.push_back(measure(scenario));
+    return ret;
+}
+
+void Benchmark::writeText(std::ostream &out, const std::vector<result_t> &results) {
+    out << std::left << std::setw(24) << "scenario" << std::right << std::setw(10) << "ops" <<
+        std::setw(16) << "ns/op" << std::setw(14) << "allocs/op" << std::setw(14) << "bytes/op" <<
+        std::setw(14) << "added/op" << std::setw(14) << "removed/op" << "\n";
+
+    for (const result_t &result : results) {
+        out << std::left << std::setw(24) << result.name << std::right << std::setw(10) <<
+            result.ops << std::setw(16) << std::fixed << std::setprecision(0) << result.nsPerOp;
+        if (Instrumentation::ENABLED) {
+            out << std::setw(14) << std::setprecision(1) << result.allocationsPerOp <<
+                std::setw(14) << std::setprecision(0) << result.bytesPerOp <<
+                std::setw(14) << std::setprecision(1) << result.entitiesAddedPerOp <<
+                std::setw(14) << result.entitiesRemovedPerOp;
+        } else {
+            for (int i = 0; i < 4; i++)
+                out << std::setw(14) << "-";
+        }
+        out << "\n";
+    }
+}
+
+void Benchmark::writeJson(std::ostream &out, const std::vector<result_t> &results) {
+    out << "{\n";
+    out << "  \"seed\": " << SEED << ",\n";
+    out << "  \"instrumented\": " << (Instrumentation::ENABLED ? "true" : "false") << ",\n";
+    out << "  \"results\": [";
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const result_t &result = results[i];
+        out << (i ? ",\n" : "\n");
+        out << "    { \"name\": \"" << result.name << "\", \"ops\": " << result.ops <<
+            ", \"nsPerOp\": " << std::fixed << std::setprecision(1) << result.nsPerOp;
+        // null in builds that don't count them, rather than 0
+        if (Instrumentation::ENABLED) {
+            out << ", \"allocationsPerOp\": " << std::setprecision(2) << result.allocationsPerOp <<
+                ", \"bytesPerOp\": " << std::setprecision(1) << result.bytesPerOp <<
+                ", \"entitiesAddedPerOp\": " << std::setprecision(2) <<
+                result.entitiesAddedPerOp << ", \"entitiesRemovedPerOp\": " <<
+                result.entitiesRemovedPerOp;
+        } else {
+            out << ", \"allocationsPerOp\": null, \"bytesPerOp\": null, " <<
+                "\"entitiesAddedPerOp\": null, \"entitiesRemovedPerOp\": null";
+        }
+        out << " }";
+    }
+
+    out << "\n  ]\n}\n";
+}
+
+}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+namespace Hilltop {
+namespace Game {
+
+// Times the simulation and drawing on matches built from the same setup every run, so the numbers
+// from two builds can be compared. Every operation is prepared outside the timed part, usually by
+// forking a match that is already set up.
+class Benchmark {
+public:
+    struct result_t {
+        std::string name;
+        uint64_t ops = 0;
+        double nsPerOp = 0.0;
+        // the rest are only counted in builds with HILLTOP_INSTRUMENT
+        double allocationsPerOp = 0.0;
+        double bytesPerOp = 0.0;
+        double entitiesAddedPerOp = 0.0;
+        double entitiesRemovedPerOp = 0.0;
+    };
+
+    static const unsigned int SEED = 1;
+    // every scenario is run once untimed, then at least this many times and for at least this long
+    static const int MIN_OPS = 5;
+    static const int MIN_MILLISECONDS = 500;
+
+    // runs every scenario with filter in its name
+    static std::vector<result_t> run(const std::string &filter = "");
+
+    static void writeText(std::ostream &out, const std::vector<result_t> &results);
+    static void writeJson(std::ostream &out, const std::vector<result_t> &results);
+
+private:
+    struct scenario_t {
+        std::string name;
+        // called before every op, returns the op to time
+        std::function<std::function<void()>()> prepare;
+    };
+
+    static std::vector<scenario_t> getScenarios();
+    static result_t measure(const scenario_t &scenario);
+};
+
+}
+}
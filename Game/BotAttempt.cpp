@@ -12,6 +12,19 @@ std::shared_ptr<BotAttempt> BotAttempt::create() {
     return std::shared_ptr<BotAttempt>(new BotAttempt());
 }
 
+std::shared_ptr<Entity> BotAttempt::clone() {
+    return std::shared_ptr<BotAttempt>(new BotAttempt(*this));
+}
+
+bool BotAttempt::copyFrom(const Entity &other) {
+    *this = static_cast<const BotAttempt &>(other);
+    return true;
+}
+
+bool BotAttempt::isTransient() {
+    return true;
+}
+
 void BotAttempt::onDraw(TankMatch *match, Console::DoublePixelBufferedConsole &console) {
     Entity::onDraw(match, console);
 
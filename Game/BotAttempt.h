@@ -29,6 +29,9 @@ public:
 
     static std::shared_ptr<BotAttempt> create();
 
+    virtual std::shared_ptr<Entity> clone() override;
+    virtual bool copyFrom(const Entity &other) override;
+    virtual bool isTransient() override;
     virtual void onDraw(TankMatch *match, Console::DoublePixelBufferedConsole &console) override;
 };
 
@@ -0,0 +1,160 @@
+#include "Game/BotLookahead.h"
+#include "Game/Tank.h"
+#include "Game/TankController.h"
+#include <atomic>
+#include <future>
+
+
+namespace Hilltop {
+namespace Game {
+
+BotPlanner::plan_t BotLookahead::search(std::shared_ptr<TankMatch> match, int playerNumber,
+    std::vector<BotPlanner::plan_t> plans, int threads) {
+    const TankController &player = *match->players[playerNumber];
+    const int count = std::min(CANDIDATES, (int)plans.size());
+    std::partial_sort(plans.begin(), plans.begin() + count, plans.end(),
+        [&player](const BotPlanner::plan_t &x, const BotPlanner::plan_t &y)->bool {
+        return BotPlanner::isBetter(x, y, player.tank->angle, player.tank->power);
+    });
+
+    const std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(TIME_BUDGET_MS);
+
+    // every candidate plays out on its own fork, the base match is only read from here on. The
+    // workers take the candidates best first, so the ones left over at the deadline matter least.
+    std::vector<std::promise<float>> scores(count);
+    std::vector<std::future<float>> results;
+    for (std::promise<float> &score : scores)
+        results.push_back(score.get_future());
+    std::atomic<int> next(0);
+    std::vector<std::future<void>> workers;
+    for (int i = 0; i < std::min(count, std::max(1, threads)); i++) {
+        workers.push_back(std::async(std::launch::async, [&, playerNumber, deadline]() {
+            for (int j = next++; j < count; j = next++)
+                scores[j].set_value(evaluate(match, playerNumber, plans[j], deadline));
+        }));
+    }
+
+    int best = 0;
+    float bestScore = 0.0f;
+    bool found = false;
+    for (int i = 0; i < count; i++) {
+        if (results[i].wait_until(deadline) != std::future_status::ready)
+            continue;
+        const float score = results[i].get();
+        if (!found || score > bestScore) {
+            found = true;
+            best = i;
+            bestScore = score;
+        }
+    }
+
+    // the workers' futures wait for them on the way out, but anything still running checks the
+    // deadline on every tick and every step of the shots it traces, so it's over soon after
+    return plans[best];
+}
+
+std::map<int, int> BotLookahead::getStrength(TankMatch &match) {
+    std::map<int, int> ret;
+    for (const std::shared_ptr<TankController> &player : match.players)
+        if (player->tank->alive)
+            ret[player->team] += player->tank->health + player->tank->armor;
+    return ret;
+}
+
+int BotLookahead::getGain(const std::map<int, int> &before, const std::map<int, int> &after,
+    int team) {
+    int ret = 0;
+    for (const std::pair<const int, int> &strength : before) {
+        std::map<int, int>::const_iterator it = after.find(strength.first);
+        const int loss = strength.second - (it == after.end() ? 0 : it->second);
+        ret += strength.first == team ? -loss : loss;
+    }
+    return ret;
+}
+
+bool BotLookahead::playShot(TankMatch &match, int playerNumber, const BotPlanner::plan_t &plan,
+    std::chrono::steady_clock::time_point deadline) {
+    TankController &player = *match.players[playerNumber];
+    if (player.tank->position != plan.position) {
+        player.tank->position = plan.position;
+        player.tank->initWheels(match);
+    }
+    player.tank->angle = plan.angle;
+    player.tank->power = plan.power;
+    player.currentWeapon = plan.weapon;
+
+    match.fire(playerNumber);
+    match.settle(SETTLE_TICKS, deadline);
+    return std::chrono::steady_clock::now() < deadline;
+}
+
+float BotLookahead::evaluate(std::shared_ptr<TankMatch> match, int playerNumber,
+    const BotPlanner::plan_t &plan, std::chrono::steady_clock::time_point deadline) {
+    const int team = match->players[playerNumber]->team;
+    const std::map<int, int> before = getStrength(*match);
+
+    std::shared_ptr<TankMatch> fork = match->fork();
+    if (!playShot(*fork, playerNumber, plan, deadline))
+        return 0.0f;
+    const std::map<int, int> afterShot = getStrength(*fork);
+    const float gain = (float)getGain(before, afterShot, team);
+
+    const int enemy = fork->getNextPlayer(playerNumber);
+    TankController &reply = *fork->players[enemy];
+    if (reply.team == team || !reply.tank->alive || !fork->players[playerNumber]->tank->alive)
+        return gain;
+
+    // the enemy answers from where it stands
+    const std::vector<BotPlanner::plan_t> replies = rankReplies(*fork, enemy,
+        fork->players[playerNumber]->tank->getBarrelBase(), REPLIES, deadline);
+    if (replies.empty())
+        return gain;
+
+    // every answer is taken as equally likely, and the bot as picking its best follow-up to each
+    float outcome = 0.0f;
+    int played = 0;
+    for (const BotPlanner::plan_t &p : replies) {
+        std::shared_ptr<TankMatch> replyFork = fork->fork();
+        if (!playShot(*replyFork, enemy, p, deadline))
+            break;
+        outcome += (float)getGain(afterShot, getStrength(*replyFork), team);
+        outcome += evaluateFollowUp(*replyFork, playerNumber, enemy, deadline);
+        played++;
+    }
+    return played > 0 ? gain + outcome / played : gain;
+}
+
+std::vector<BotPlanner::plan_t> BotLookahead::rankReplies(TankMatch &match, int playerNumber,
+    Vector2 target, int count, std::chrono::steady_clock::time_point deadline) {
+    TankController &player = *match.players[playerNumber];
+    BotPlanner::request_t request = BotPlanner::prepare(&match, player, 0,
+        std::make_shared<TankMatch::Land>(match.land),
+        BotPlanner::buildGrid(REPLY_ANGLE_STEP, REPLY_POWER_STEP));
+    request.target = target;
+    request.deadline = deadline;
+    return BotPlanner::rankShots(request, { player.tank->position, 0 }, count);
+}
+
+float BotLookahead::evaluateFollowUp(TankMatch &match, int playerNumber, int enemy,
+    std::chrono::steady_clock::time_point deadline) {
+    if (!match.players[playerNumber]->tank->alive || !match.players[enemy]->tank->alive)
+        return 0.0f;
+
+    const int team = match.players[playerNumber]->team;
+    const std::map<int, int> before = getStrength(match);
+    const std::vector<BotPlanner::plan_t> followUps = rankReplies(match, playerNumber,
+        match.players[enemy]->tank->getBarrelBase(), FOLLOW_UPS, deadline);
+
+    float best = 0.0f;
+    for (const BotPlanner::plan_t &p : followUps) {
+        std::shared_ptr<TankMatch> fork = match.fork();
+        if (!playShot(*fork, playerNumber, p, deadline))
+            break;
+        best = std::max(best, (float)getGain(before, getStrength(*fork), team));
+    }
+    return best;
+}
+
+}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Game/BotPlanner.h"
+#include <chrono>
+
+
+namespace Hilltop {
+namespace Game {
+
+// Picks between the planner's best shots by playing them out on forks of the match, three turns
+// deep: the shot, the next enemy's likeliest answers to it, and the bot's best follow-up to each
+// answer. Whoever else plays in between is skipped, what they do is too hard to guess to be worth
+// the time.
+class BotLookahead {
+public:
+    static const int CANDIDATES = 6;
+    static const int REPLIES = 3;
+    static const int FOLLOW_UPS = 2;
+    static const int SETTLE_TICKS = 400;
+    static const int TIME_BUDGET_MS = 2000;
+    static const int REPLY_ANGLE_STEP = 10;
+    static const int REPLY_POWER_STEP = 10;
+
+    // falls back to the planner's own favorite for anything that doesn't finish in time, plays
+    // out at most threads candidates at once
+    static BotPlanner::plan_t search(std::shared_ptr<TankMatch> match, int playerNumber,
+        std::vector<BotPlanner::plan_t> plans, int threads);
+
+private:
+    // hit points and armor each team has left
+    static std::map<int, int> getStrength(TankMatch &match);
+    static int getGain(const std::map<int, int> &before, const std::map<int, int> &after, int team);
+    // returns false if the shot was still playing out at the deadline
+    static bool playShot(TankMatch &match, int playerNumber, const BotPlanner::plan_t &plan,
+        std::chrono::steady_clock::time_point deadline);
+    // the likeliest shots for a player that stays put, on a coarse grid aimed at target, or none
+    // if the deadline passes first
+    static std::vector<BotPlanner::plan_t> rankReplies(TankMatch &match, int playerNumber,
+        Vector2 target, int count, std::chrono::steady_clock::time_point deadline);
+    // the most the bot gains with its next shot, or nothing if it can't find one in time
+    static float evaluateFollowUp(TankMatch &match, int playerNumber, int enemy,
+        std::chrono::steady_clock::time_point deadline);
+    // stops early once the deadline passes, the score is thrown away then anyway
+    static float evaluate(std::shared_ptr<TankMatch> match, int playerNumber,
+        const BotPlanner::plan_t &plan, std::chrono::steady_clock::time_point deadline);
+};
+
+}
+}
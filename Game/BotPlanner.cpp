@@ -0,0 +1,244 @@
+#include "Game/BotPlanner.h"
+#include "Game/BotLookahead.h"
+#include "Game/ShotEvaluator.h"
+#include "Game/TankController.h"
+#include <future>
+#include <thread>
+
+
+namespace Hilltop {
+namespace Game {
+
+std::vector<BotPlanner::position_t> BotPlanner::findReachablePositions(const TankMatch::Land &land,
+    Vector2 start, int maxMoves) {
+    std::vector<position_t> positions;
+    positions.push_back({ Tank::calcSettled(land, start), 0 });
+
+    for (int direction = -1; direction <= 1; direction += 2) {
+        Vector2 p = positions[0].position;
+        for (int i = 1; i <= maxMoves; i++) {
+            Vector2 next = Tank::calcMove(land, p, direction);
+            if (next == p)
+                break;
+            p = Tank::calcSettled(land, next);
+            positions.push_back({ p, i * direction });
+        }
+    }
+
+    return positions;
+}
+
+std::vector<BotPlanner::shot_t> BotPlanner::buildShots(TankController &player) {
+    std::vector<shot_t> shots;
+
+    for (int mult = -1; mult <= 1; mult += 2) {
+        for (int i = -10; i <= 10; i++) {
+            int angleOff;
+            int powerOff;
+            if (i >= -5 && i <= 5) {
+                angleOff = i;
+                powerOff = i;
+            } else {
+                angleOff = i * 4;
+                powerOff = i * 3;
+            }
+
+            shot_t shot;
+            shot.angle = std::max(0, std::min(180, player.tank->angle + angleOff * mult));
+            shot.power = std::max(0, std::min(100, player.tank->power + powerOff));
+            shots.push_back(shot);
+        }
+    }
+
+    for (int i = 0; i < TankController::RANDOM_ATTEMPTS_BY_BOT_DIFFICULTY[player.botDifficulty]; i++) {
+        shot_t shot;
+        shot.angle = scale(rand(), 0, RAND_MAX, 0, 180);
+        shot.power = scale(rand(), 0, RAND_MAX, 0, 100);
+        shots.push_back(shot);
+    }
+
+    return shots;
+}
+
+std::vector<BotPlanner::shot_t> BotPlanner::buildGrid(int angleStep, int powerStep) {
+    std::vector<shot_t> shots;
+    for (int angle = 0; angle <= 180; angle += angleStep)
+        for (int power = powerStep; power <= 100; power += powerStep)
+            shots.push_back({ angle, power });
+    return shots;
+}
+
+std::vector<BotPlanner::weapon_t> BotPlanner::buildWeapons(TankController &player) {
+    std::vector<weapon_t> weapons;
+    for (int i = 0; i < player.weapons.size(); i++)
+        if (player.weapons[i].second > 0)
+            weapons.push_back({ i, player.weapons[i].first->getProfile() });
+    return weapons;
+}
+
+std::vector<ShotEvaluator::target_t> BotPlanner::buildTargets(TankMatch *match, TankController &player,
+    int &self) {
+    std::vector<ShotEvaluator::target_t> targets;
+    self = -1;
+    for (const std::shared_ptr<TankController> &p : match->players) {
+        if (!p->tank->alive)
+            continue;
+        if (p->tank == player.tank)
+            self = (int)targets.size();
+
+        ShotEvaluator::target_t target;
+        target.barrelBase = p->tank->getBarrelBase();
+        target.pixels = p->tank->getPixels();
+        target.team = p->team;
+        target.hitPoints = p->tank->health + p->tank->armor;
+        targets.push_back(target);
+    }
+    return targets;
+}
+
+BotPlanner::plan_t BotPlanner::evaluatePosition(const request_t &request, const position_t &position) {
+    std::vector<plan_t> ranked = rankShots(request, position, 1);
+    if (!ranked.empty())
+        return ranked[0];
+
+    plan_t ret;
+    ret.position = position.position;
+    ret.moves = position.moves;
+    return ret;
+}
+
+std::vector<BotPlanner::plan_t> BotPlanner::rankShots(const request_t &request,
+    const position_t &position, int count) {
+    static const int MAX_STEPS = TankController::BOT_MAX_ATTEMPT_TIME * TankController::BOT_ATTEMPT_SPEED;
+
+    // our own tank is wherever this position puts it
+    std::vector<ShotEvaluator::target_t> targets = request.targets;
+    if (request.self >= 0) {
+        targets[request.self].barrelBase = Tank::getBarrelBase(position.position);
+        targets[request.self].pixels = Tank::getPixels(position.position, request.angle);
+    }
+
+    ShotEvaluator evaluator(*request.land, request.gravity, request.stepsPerSecond, targets,
+        request.team, MAX_STEPS);
+    Vector2 barrelBase = Tank::getBarrelBase(position.position);
+    std::vector<int> ids;
+    for (const weapon_t &weapon : request.weapons)
+        for (const shot_t &shot : request.shots)
+            ids.push_back(evaluator.addShot(weapon.profile, barrelBase, shot.angle, shot.power));
+    if (!evaluator.run(request.deadline))
+        return std::vector<plan_t>();
+
+    std::vector<plan_t> plans;
+    int id = 0;
+    for (const weapon_t &weapon : request.weapons) {
+        for (const shot_t &shot : request.shots) {
+            ShotEvaluator::shot_t result = evaluator.evaluate(ids[id++]);
+            if (!result.hit && result.damage == 0)
+                continue;
+
+            plan_t p;
+            p.position = position.position;
+            p.moves = position.moves;
+            p.impact = result.impact.round();
+            p.weapon = weapon.index;
+            p.angle = shot.angle;
+            p.power = shot.power;
+            p.damage = result.damage;
+            p.score = result.hit ? distance(request.target, p.impact) :
+                std::numeric_limits<float>::infinity();
+            plans.push_back(p);
+        }
+    }
+
+    count = std::min(count, (int)plans.size());
+    std::partial_sort(plans.begin(), plans.begin() + count, plans.end(),
+        [&request](const plan_t &x, const plan_t &y)->bool {
+        return isBetter(x, y, request.angle, request.power);
+    });
+    plans.resize(count);
+    return plans;
+}
+
+bool BotPlanner::isBetter(const plan_t &x, const plan_t &y, int angle, int power) {
+    if (x.damage != y.damage)
+        return x.damage > y.damage;
+
+    if (x.score != y.score)
+        return x.score < y.score;
+
+    if (std::abs(x.moves) != std::abs(y.moves))
+        return std::abs(x.moves) < std::abs(y.moves);
+
+    if (x.angle != y.angle)
+        return std::abs(angle - x.angle) < std::abs(angle - y.angle);
+
+    return std::abs(power - x.power) < std::abs(power - y.power);
+}
+
+int BotPlanner::shareThreads(int plans) {
+    return std::max(1, (int)std::thread::hardware_concurrency() / std::max(1, plans));
+}
+
+BotPlanner::request_t BotPlanner::prepare(TankMatch *match, TankController &player, int maxMoves,
+    std::shared_ptr<const TankMatch::Land> land, std::vector<shot_t> shots) {
+    request_t request;
+    request.land = land;
+    request.gravity = match->gravity;
+    request.stepsPerSecond = match->ticksPerSecond * match->getStepsPerTick();
+    request.start = player.tank->position;
+    request.maxMoves = maxMoves;
+    request.shots = shots;
+    request.weapons = buildWeapons(player);
+    request.targets = buildTargets(match, player, request.self);
+    request.team = player.team;
+    request.target = player.botTarget;
+    request.angle = player.tank->angle;
+    request.power = player.tank->power;
+    request.keepCandidates = BotAttempt::enableDebug;
+    return request;
+}
+
+BotPlanner::result_t BotPlanner::run(const request_t &request) {
+    const std::vector<position_t> positions = findReachablePositions(*request.land, request.start,
+        request.maxMoves);
+
+    // the land is only read while planning, so every worker can share it
+    const size_t threads = std::max(1, request.threads);
+    const size_t chunk = (positions.size() + threads - 1) / threads;
+    std::vector<std::future<std::vector<plan_t>>> futures;
+    for (size_t begin = 0; begin < positions.size(); begin += chunk) {
+        const size_t end = std::min(positions.size(), begin + chunk);
+        futures.push_back(std::async(std::launch::async, [&, begin, end]()->std::vector<plan_t> {
+            std::vector<plan_t> ret;
+            for (size_t i = begin; i < end; i++)
+                ret.push_back(evaluatePosition(request, positions[i]));
+            return ret;
+        }));
+    }
+
+    result_t result;
+    result.best.position = positions[0].position;
+    result.best.angle = request.angle;
+    result.best.power = request.power;
+    std::vector<plan_t> plans;
+    for (std::future<std::vector<plan_t>> &future : futures) {
+        for (const plan_t &p : future.get()) {
+            if (p.angle == -1)
+                continue;
+            plans.push_back(p);
+            if (isBetter(p, result.best, request.angle, request.power))
+                result.best = p;
+        }
+    }
+
+    if (request.fork && !plans.empty())
+        result.best = BotLookahead::search(request.fork, request.playerNumber, plans,
+            request.threads);
+    if (request.keepCandidates)
+        result.candidates = plans;
+
+    return result;
+}
+
+}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Game/ShotEvaluator.h"
+#include "Game/TankMatch.h"
+#include <limits>
+
+
+namespace Hilltop {
+namespace Game {
+
+class TankController;
+
+class BotPlanner {
+public:
+    struct shot_t {
+        int angle;
+        int power;
+    };
+
+    struct position_t {
+        Vector2 position;
+        int moves;
+    };
+
+    struct weapon_t {
+        int index;
+        Weapon::profile_t profile;
+    };
+
+    struct plan_t {
+        Vector2 position;
+        Vector2 impact;
+        int moves = 0;
+        int weapon = -1;
+        int angle = -1;
+        int power = -1;
+        int damage = 0;
+        float score = std::numeric_limits<float>::infinity();
+    };
+
+    // everything a plan needs, copied out of the match so it can be worked on from any thread
+    struct request_t {
+        std::shared_ptr<const TankMatch::Land> land;
+        Vector2 gravity;
+        int stepsPerSecond;
+        Vector2 start;
+        int maxMoves;
+        std::vector<shot_t> shots;
+        std::vector<weapon_t> weapons;
+        std::vector<ShotEvaluator::target_t> targets;
+        int self;
+        int team;
+        Vector2 target;
+        int angle;
+        int power;
+        bool keepCandidates;
+        // how many threads the plan is worked out on, see shareThreads()
+        int threads = 1;
+        // rankShots() gives up and finds nothing once it passes
+        std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::time_point::max();
+
+        // set for bots that search ahead, a headless fork of the match and who is planning in it
+        std::shared_ptr<TankMatch> fork;
+        int playerNumber = -1;
+    };
+
+    struct result_t {
+        plan_t best;
+        std::vector<plan_t> candidates;
+    };
+
+    static std::vector<position_t> findReachablePositions(const TankMatch::Land &land, Vector2 start,
+        int maxMoves);
+    static std::vector<shot_t> buildShots(TankController &player);
+    static std::vector<shot_t> buildGrid(int angleStep, int powerStep);
+    static std::vector<weapon_t> buildWeapons(TankController &player);
+    static std::vector<ShotEvaluator::target_t> buildTargets(TankMatch *match, TankController &player,
+        int &self);
+    static plan_t evaluatePosition(const request_t &request, const position_t &position);
+    // the best count shots from a position, best first
+    static std::vector<plan_t> rankShots(const request_t &request, const position_t &position,
+        int count);
+    static bool isBetter(const plan_t &x, const plan_t &y, int angle, int power);
+    // the threads each of the given number of plans worked out at once gets, so that together
+    // they keep every core busy without piling more threads on them
+    static int shareThreads(int plans);
+
+    // reads the match and uses rand(), so it has to run on the game thread
+    static request_t prepare(TankMatch *match, TankController &player, int maxMoves,
+        std::shared_ptr<const TankMatch::Land> land, std::vector<shot_t> shots);
+    static result_t run(const request_t &request);
+};
+
+}
+}
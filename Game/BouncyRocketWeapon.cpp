@@ -15,5 +15,13 @@ std::shared_ptr<Entity> BouncyRocketWeapon::createRocket(Vector2 position,
 
 BouncyRocketWeapon::BouncyRocketWeapon() : RocketWeapon(1) {}
 
+Weapon::profile_t BouncyRocketWeapon::getProfile() {
+    profile_t profile = RocketWeapon::getProfile();
+    profile.kind = profile_t::BOUNCY;
+    // the rockets keep their own explosion size, not the weapon's
+    profile.explosionSize = SimpleRocket::DEFAULT_EXPLOSION_SIZE;
+    return profile;
+}
+
 }
 }
@@ -19,6 +19,8 @@ protected:
 
 public:
     BouncyRocketWeapon();
+
+    virtual profile_t getProfile() override;
 };
 
 }
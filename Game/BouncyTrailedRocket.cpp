@@ -13,6 +13,15 @@ std::shared_ptr<BouncyTrailedRocket> BouncyTrailedRocket::create() {
     return std::shared_ptr<BouncyTrailedRocket>(new BouncyTrailedRocket());
 }
 
+std::shared_ptr<Entity> BouncyTrailedRocket::clone() {
+    return std::shared_ptr<BouncyTrailedRocket>(new BouncyTrailedRocket(*this));
+}
+
+bool BouncyTrailedRocket::copyFrom(const Entity &other) {
+    *this = static_cast<const BouncyTrailedRocket &>(other);
+    return true;
+}
+
 void BouncyTrailedRocket::onHit(TankMatch *match) {
     Vector2 d = direction;
 
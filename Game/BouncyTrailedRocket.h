@@ -25,6 +25,8 @@ public:
 
     static std::shared_ptr<BouncyTrailedRocket> create();
 
+    virtual std::shared_ptr<Entity> clone() override;
+    virtual bool copyFrom(const Entity &other) override;
     virtual void onHit(TankMatch *match) override;
 
     void finish(TankMatch *match);
@@ -12,18 +12,27 @@ std::shared_ptr<BulletRainCloud> BulletRainCloud::create() {
     return std::shared_ptr<BulletRainCloud>(new BulletRainCloud());
 }
 
+std::shared_ptr<Entity> BulletRainCloud::clone() {
+    return std::shared_ptr<BulletRainCloud>(new BulletRainCloud(*this));
+}
+
+bool BulletRainCloud::copyFrom(const Entity &other) {
+    *this = static_cast<const BulletRainCloud &>(other);
+    return true;
+}
+
 void BulletRainCloud::onTick(TankMatch *match) {
     Entity::onTick(match);
 
-    if (hasHit && entityAge % BULLET_EVERY_TICKS == 0) {
+    if (hasHit && match->countDue(entityAge, BULLET_EVERY_TICKS)) {
         Vector2 p = position.round();
         int left = p.Y - CLOUD_WIDTH / 2;
         int right = p.Y + CLOUD_WIDTH / 2;
-        int pos = scale(rand(), 0, RAND_MAX, left, right);
+        int pos = scale(match->random(), 0, TankMatch::RANDOM_MAX, left, right);
         std::shared_ptr<SimpleTrailedRocket> rocket =
             SimpleTrailedRocket::create(Console::YELLOW, Console::DARK_GRAY, 1);
         rocket->position = Vector2(-10.0f, (float)pos);
-        rocket->explosionSize = 3;
+        rocket->explosionSize = RAIN_EXPLOSION_SIZE;
         rocket->explosionDamage = RAIN_DAMAGE;
         match->addEntity(*rocket);
     }
@@ -39,7 +48,7 @@ void BulletRainCloud::onDraw(TankMatch *match, Console::DoublePixelBufferedConso
 
 void BulletRainCloud::onHit(TankMatch *match) {
     if (!hasHit)
-        maxEntityAge = entityAge + RAIN_TICKS;
+        maxEntityAge = (int)match->toDefaultTicks(entityAge) + RAIN_TICKS;
 
     Entity::onHit(match);
 }
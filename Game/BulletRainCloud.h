@@ -21,10 +21,13 @@ public:
     static const int BULLET_EVERY_TICKS = 1;
     static const int CLOUD_WIDTH = 16;
     static const int RAIN_TICKS = 32;
+    static const int RAIN_EXPLOSION_SIZE = 3;
     static constexpr float RAIN_DAMAGE = 0.55f;
 
     static std::shared_ptr<BulletRainCloud> create();
 
+    virtual std::shared_ptr<Entity> clone() override;
+    virtual bool copyFrom(const Entity &other) override;
     virtual void onTick(TankMatch *match) override;
     virtual void onDraw(TankMatch *match, Console::DoublePixelBufferedConsole &console) override;
     virtual void onHit(TankMatch *match) override;
@@ -18,5 +18,14 @@ void Hilltop::Game::BulletRainWeapon::fire(TankMatch &match, int playerNumber) {
     match.addEntity(*cloud);
 }
 
+Weapon::profile_t Hilltop::Game::BulletRainWeapon::getProfile() {
+    profile_t profile;
+    profile.kind = profile_t::BULLET_RAIN;
+    profile.numRockets = BulletRainCloud::RAIN_TICKS;
+    profile.explosionSize = BulletRainCloud::RAIN_EXPLOSION_SIZE;
+    profile.explosionDamage = BulletRainCloud::RAIN_DAMAGE;
+    return profile;
+}
+
 }
 }
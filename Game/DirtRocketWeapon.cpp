@@ -17,5 +17,12 @@ std::shared_ptr<Entity> DirtRocketWeapon::createRocket(Vector2 position,
 
 DirtRocketWeapon::DirtRocketWeapon(int numRockets) : RocketWeapon(numRockets) {}
 
+Weapon::profile_t DirtRocketWeapon::getProfile() {
+    profile_t profile = RocketWeapon::getProfile();
+    // explosions only hit tanks when they also destroy land
+    profile.damagesTanks = false;
+    return profile;
+}
+
 }
 }
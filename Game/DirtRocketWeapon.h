@@ -21,6 +21,8 @@ protected:
 
 public:
     DirtRocketWeapon(int numRockets);
+
+    virtual profile_t getProfile() override;
 };
 
 template<class Archive>
@@ -1,4 +1,5 @@
 #include "Game/Entity.h"
+#include "Game/Hash.h"
 #include "Game/TankMatch.h"
 
 
@@ -13,11 +14,37 @@ std::shared_ptr<Entity> Entity::create() {
     return std::shared_ptr<Entity>(new Entity());
 }
 
+std::shared_ptr<Entity> Entity::clone() {
+    return std::shared_ptr<Entity>(new Entity(*this));
+}
+
+bool Entity::copyFrom(const Entity &other) {
+    *this = other;
+    return true;
+}
+
+void Entity::relink(const clone_map_t &clones) {}
+
+bool Entity::isTransient() {
+    return false;
+}
+
+uint64_t Entity::getHash() const {
+    uint64_t ret = 0;
+    addHash(ret, position);
+    addHash(ret, direction);
+    addHash(ret, gravityMult);
+    addHash(ret, (uint64_t)entityAge);
+    addHash(ret, (uint64_t)(groundHog | hasHit << 1 | hasExpired << 2));
+    return ret;
+}
+
 void Entity::onTick(TankMatch *match) {
     entityAge++;
 
+    // maxEntityAge is in ticks at the default rate
     if (maxEntityAge >= 0)
-        if (entityAge > maxEntityAge)
+        if (match->toDefaultTicks(entityAge) > (uint64_t)maxEntityAge)
             onExpire(match);
 }
 
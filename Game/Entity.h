@@ -3,6 +3,7 @@
 #include "Game/Vector2.h"
 #include "Console/BufferedConsole.h"
 #include "Console/DoublePixelBufferedConsole.h"
+#include <map>
 #include <memory>
 
 
@@ -25,13 +26,20 @@ private:
         ar & entityAge;
         ar & maxEntityAge;
         ar & physicsSpeed;
+
+        if (Archive::is_loading::value)
+            previousPosition = position;
     }
 
 protected:
     Entity();
 
 public:
+    typedef std::map<const Entity *, std::shared_ptr<Entity>> clone_map_t;
+
     Vector2 position = { -1.0f, -1.0f };
+    // where the entity was before the last tick, for drawing it in between
+    Vector2 previousPosition = { -1.0f, -1.0f };
     Vector2 direction = { 0.0f, 0.0f };
     float gravityMult = 1.0f;
 
@@ -41,10 +49,31 @@ public:
     int entityAge = 0;
     int maxEntityAge = -1;
     int physicsSpeed = 1;
+    // what getHash() gave when the match last hashed the entity, its share of the match's hash
+    uint64_t hashKey = 0;
 
     virtual ~Entity();
     static std::shared_ptr<Entity> create();
 
+    // copies the entity for TankMatch::fork, references to other entities are fixed up by relink
+    virtual std::shared_ptr<Entity> clone();
+    // the same as clone(), but into an entity of the same type that already exists, returns false
+    // when it can't and clone() has to be used instead
+    virtual bool copyFrom(const Entity &other);
+    virtual void relink(const clone_map_t &clones);
+    // purely visual entities that saves and forks leave out, and that never keep a turn going
+    virtual bool isTransient();
+    // of everything about the entity that affects how the match plays out
+    virtual uint64_t getHash() const;
+
+    template<class T>
+    static std::shared_ptr<T> relinked(const clone_map_t &clones, const std::shared_ptr<T> &entity) {
+        clone_map_t::const_iterator it = clones.find(entity.get());
+        if (it == clones.end())
+            return entity;
+        return std::static_pointer_cast<T>(it->second);
+    }
+
     virtual void onTick(TankMatch *match);
     virtual void onDraw(TankMatch *match, Console::DoublePixelBufferedConsole &console);
     virtual void onDirectDraw(TankMatch *match, Console::BufferedConsole &console);
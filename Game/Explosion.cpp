@@ -1,4 +1,5 @@
 #include "Game/Explosion.h"
+#include "Game/Profiler.h"
 #include "Game/TankController.h"
 #include "Game/TankMatch.h"
 #include "resource.h"
@@ -15,8 +16,6 @@ static void playSound() {
 Explosion::Explosion(int size) : Entity(), size(size) {
     gravityMult = 0.0f;
     coreSize = size - 1;
-
-    playSound();
 }
 
 void Explosion::destroyLand(TankMatch *match) {
@@ -37,7 +36,11 @@ void Explosion::createLand(TankMatch *match) {
 }
 
 int Explosion::calcDamage(Vector2 point) {
-    return std::max<int>(1, scale(distance(position.round(), point), 0, size, 8 * size, 1) * damageMult);
+    return calcDamage(size, damageMult, position.round(), point);
+}
+
+int Explosion::calcDamage(int size, float damageMult, Vector2 center, Vector2 point) {
+    return std::max<int>(1, scale(distance(center, point), 0, size, 8 * size, 1) * damageMult);
 }
 
 void Explosion::hitTanks(TankMatch *match) {
@@ -64,10 +67,50 @@ std::shared_ptr<Explosion> Explosion::create(int size) {
     return std::shared_ptr<Explosion>(new Explosion(size));
 }
 
+std::shared_ptr<Entity> Explosion::clone() {
+    return std::shared_ptr<Explosion>(new Explosion(*this));
+}
+
+bool Explosion::copyFrom(const Entity &other) {
+    // the size never changes, so only an explosion of the same size can be copied over
+    const Explosion &explosion = static_cast<const Explosion &>(other);
+    if (explosion.size != size)
+        return false;
+
+    Entity::copyFrom(other);
+    coreSize = explosion.coreSize;
+    damageMult = explosion.damageMult;
+    willDestroyLand = explosion.willDestroyLand;
+    willCreateLand = explosion.willCreateLand;
+    tanksHit = explosion.tanksHit;
+    return true;
+}
+
+void Explosion::relink(const clone_map_t &clones) {
+    Entity::relink(clones);
+
+    std::set<std::shared_ptr<Tank>> hit;
+    for (const std::shared_ptr<Tank> &tank : tanksHit)
+        hit.insert(relinked(clones, tank));
+    tanksHit = hit;
+}
+
+bool Explosion::isTransient() {
+    return !willDestroyLand && !willCreateLand;
+}
+
 void Explosion::onTick(TankMatch *match) {
+    HILLTOP_PROFILE_SCOPE(Profiler::EXPLOSION, !match->headless);
     Entity::onTick(match);
 
-    if (entityAge >= 2) {
+    // counted in ticks at the default rate, so the land goes at the same time at any rate
+    const uint64_t age = match->toDefaultTicks(entityAge);
+
+    // played from the first tick rather than the constructor, so forks and loaded saves stay quiet
+    if (age == 1 && match->countDue(entityAge, 1) && !match->headless)
+        playSound();
+
+    if (age >= 2) {
         if (willDestroyLand) {
             willDestroyLand = false;
             destroyLand(match);
@@ -79,7 +122,7 @@ void Explosion::onTick(TankMatch *match) {
         }
     }
 
-    if (entityAge % ticksBetween == 0) {
+    if (match->countDue(entityAge, ticksBetween)) {
         if (coreSize <= 1) {
             match->removeEntity(*this);
         } else {
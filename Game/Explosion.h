@@ -2,6 +2,7 @@
 
 #include "Game/Entity.h"
 #include "Game/Tank.h"
+#include <boost/serialization/version.hpp>
 #include <set>
 
 
@@ -19,6 +20,10 @@ private:
         ar & coreSize;
         ar & damageMult;
         ar & tanksHit;
+        if (version >= 1) {
+            ar & willDestroyLand;
+            ar & willCreateLand;
+        }
     }
 
 protected:
@@ -39,10 +44,16 @@ public:
 
     std::set<std::shared_ptr<Tank>> tanksHit;
     int calcDamage(Vector2 point);
+    static int calcDamage(int size, float damageMult, Vector2 center, Vector2 point);
     void hitTanks(TankMatch *match);
 
     static std::shared_ptr<Explosion> create(int size);
 
+    virtual std::shared_ptr<Entity> clone() override;
+    virtual bool copyFrom(const Entity &other) override;
+    virtual void relink(const clone_map_t &clones) override;
+    // only while it still has land to change
+    virtual bool isTransient() override;
     virtual void onTick(TankMatch *match) override;
     virtual void onDraw(TankMatch *match, Console::DoublePixelBufferedConsole &console) override;
 };
@@ -61,3 +72,5 @@ void load_construct_data(Archive &ar, Explosion *t, const unsigned int) {
 
 }
 }
+
+BOOST_CLASS_VERSION(Hilltop::Game::Explosion, 1)
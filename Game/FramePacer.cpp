@@ -0,0 +1,61 @@
+#include "Game/FramePacer.h"
+#include <algorithm>
+#include <thread>
+
+
+namespace Hilltop {
+namespace Game {
+
+FramePacer::FramePacer(clock_t::duration period, int maxCatchUp)
+    : period(period), maxCatchUp(maxCatchUp) {
+    reset();
+}
+
+int FramePacer::wait() {
+    std::this_thread::sleep_until(deadline);
+
+    const clock_t::duration late = clock_t::now() - deadline;
+    totalJitter += late;
+    maxJitter = std::max(maxJitter, late);
+
+    // everything that came due while we were late, plus the tick we woke up for
+    const int64_t due = 1 + late / period;
+    deadline += period * due;
+
+    const int ret = (int)std::min<int64_t>(due, maxCatchUp);
+    droppedTicks += due - ret;
+    ticks += ret;
+    frames++;
+    return ret;
+}
+
+void FramePacer::reset() {
+    deadline = clock_t::now() + period;
+}
+
+FramePacer::clock_t::duration FramePacer::getPeriod() const {
+    return period;
+}
+
+uint64_t FramePacer::getFrames() const {
+    return frames;
+}
+
+uint64_t FramePacer::getTicks() const {
+    return ticks;
+}
+
+uint64_t FramePacer::getDroppedTicks() const {
+    return droppedTicks;
+}
+
+FramePacer::clock_t::duration FramePacer::getAverageJitter() const {
+    return frames ? totalJitter / (int64_t)frames : clock_t::duration::zero();
+}
+
+FramePacer::clock_t::duration FramePacer::getMaxJitter() const {
+    return maxJitter;
+}
+
+}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+
+namespace Hilltop {
+namespace Game {
+
+// Keeps a loop running at a fixed rate by sleeping until each deadline instead of polling. The
+// deadlines stay on the same schedule however late a wakeup is, and a loop that falls behind gets
+// to catch up on at most maxCatchUp ticks at once, anything past that is dropped.
+class FramePacer {
+public:
+    typedef std::chrono::steady_clock clock_t;
+
+    FramePacer(clock_t::duration period, int maxCatchUp);
+
+    // sleeps until the next deadline, returns how many ticks are due, at least one
+    int wait();
+    // starts the schedule over from now, for when the loop was held up on purpose
+    void reset();
+
+    clock_t::duration getPeriod() const;
+    uint64_t getFrames() const;
+    uint64_t getTicks() const;
+    uint64_t getDroppedTicks() const;
+    // how late wakeups were past their deadline, on average and at worst
+    clock_t::duration getAverageJitter() const;
+    clock_t::duration getMaxJitter() const;
+
+private:
+    const clock_t::duration period;
+    const int maxCatchUp;
+    clock_t::time_point deadline;
+
+    uint64_t frames = 0;
+    uint64_t ticks = 0;
+    uint64_t droppedTicks = 0;
+    clock_t::duration totalJitter = clock_t::duration::zero();
+    clock_t::duration maxJitter = clock_t::duration::zero();
+};
+
+}
+}
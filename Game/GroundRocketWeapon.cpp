@@ -15,5 +15,13 @@ std::shared_ptr<Entity> GroundRocketWeapon::createRocket(Vector2 position,
 
 GroundRocketWeapon::GroundRocketWeapon(int numRockets) : RocketWeapon(numRockets) {}
 
+Weapon::profile_t GroundRocketWeapon::getProfile() {
+    profile_t profile = RocketWeapon::getProfile();
+    profile.kind = profile_t::GROUND;
+    // the rockets keep their own explosion size, not the weapon's
+    profile.explosionSize = SimpleRocket::DEFAULT_EXPLOSION_SIZE;
+    return profile;
+}
+
 }
 }
@@ -21,6 +21,8 @@ protected:
 
 public:
     GroundRocketWeapon(int numRockets);
+
+    virtual profile_t getProfile() override;
 };
 
 template<class Archive>
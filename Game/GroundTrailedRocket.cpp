@@ -13,10 +13,19 @@ std::shared_ptr<GroundTrailedRocket> GroundTrailedRocket::create() {
     return std::shared_ptr<GroundTrailedRocket>(new GroundTrailedRocket());
 }
 
+std::shared_ptr<Entity> GroundTrailedRocket::clone() {
+    return std::shared_ptr<GroundTrailedRocket>(new GroundTrailedRocket(*this));
+}
+
+bool GroundTrailedRocket::copyFrom(const Entity &other) {
+    *this = static_cast<const GroundTrailedRocket &>(other);
+    return true;
+}
+
 void GroundTrailedRocket::onTick(TankMatch *match) {
     SimpleTrailedRocket::onTick(match);
 
-    if (entityAge <= 10)
+    if (match->toDefaultTicks(entityAge) <= 10)
         return;
 
     Vector2 p = position.round();
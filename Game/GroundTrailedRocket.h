@@ -20,6 +20,8 @@ protected:
 public:
     static std::shared_ptr<GroundTrailedRocket> create();
 
+    virtual std::shared_ptr<Entity> clone() override;
+    virtual bool copyFrom(const Entity &other) override;
     virtual void onTick(TankMatch *match) override;
     virtual void onHit(TankMatch *match) override;
 };
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Game/Vector2.h"
+#include <cstdint>
+#include <cstring>
+
+
+namespace Hilltop {
+namespace Game {
+
+// the finalizer of splitmix64, every bit of the input affects every bit of the output
+inline uint64_t mixHash(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+inline void addHash(uint64_t &hash, uint64_t value) {
+    hash = mixHash(hash ^ value) + 0x9E3779B97F4A7C15ULL;
+}
+
+inline void addHash(uint64_t &hash, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    addHash(hash, (uint64_t)bits);
+}
+
+inline void addHash(uint64_t &hash, Vector2 value) {
+    addHash(hash, value.X);
+    addHash(hash, value.Y);
+}
+
+}
+}
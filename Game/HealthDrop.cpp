@@ -13,6 +13,15 @@ std::shared_ptr<HealthDrop> HealthDrop::create() {
     return std::shared_ptr<HealthDrop>(new HealthDrop());
 }
 
+std::shared_ptr<Entity> HealthDrop::clone() {
+    return std::shared_ptr<HealthDrop>(new HealthDrop(*this));
+}
+
+bool HealthDrop::copyFrom(const Entity &other) {
+    *this = static_cast<const HealthDrop &>(other);
+    return true;
+}
+
 void HealthDrop::handleTank(TankMatch *match, Tank &tank) {
     tank.health = std::min(tank.maxHealth, tank.health + HEALTH);
 }
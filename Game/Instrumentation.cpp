@@ -0,0 +1,103 @@
+#include "Game/Instrumentation.h"
+#include <atomic>
+#include <boost/core/demangle.hpp>
+#include <cstdlib>
+#include <new>
+
+
+namespace Hilltop {
+namespace Game {
+
+Instrumentation::counters_t Instrumentation::counters_t::operator-(const counters_t &other) const {
+    counters_t ret;
+    ret.allocations = allocations - other.allocations;
+    ret.bytes = bytes - other.bytes;
+    ret.entitiesAdded = entitiesAdded - other.entitiesAdded;
+    ret.entitiesRemoved = entitiesRemoved - other.entitiesRemoved;
+    return ret;
+}
+
+std::string Instrumentation::getTypeName(std::type_index type) {
+    const std::string name = boost::core::demangle(type.name());
+    const size_t start = name.find_last_of(": ");
+    return start == std::string::npos ? name : name.substr(start + 1);
+}
+
+#ifdef HILLTOP_INSTRUMENT
+
+static std::atomic<uint64_t> allocations(0);
+static std::atomic<uint64_t> allocationBytes(0);
+static std::atomic<uint64_t> entitiesAdded(0);
+static std::atomic<uint64_t> entitiesRemoved(0);
+// plain integers, so counting them can't allocate on a thread's first allocation
+static thread_local uint64_t threadAllocations = 0;
+static thread_local uint64_t threadAllocationBytes = 0;
+static thread_local uint64_t threadEntitiesAdded = 0;
+static thread_local uint64_t threadEntitiesRemoved = 0;
+
+Instrumentation::counters_t Instrumentation::getTotals() {
+    counters_t ret;
+    ret.allocations = allocations.load(std::memory_order_relaxed);
+    ret.bytes = allocationBytes.load(std::memory_order_relaxed);
+    ret.entitiesAdded = entitiesAdded.load(std::memory_order_relaxed);
+    ret.entitiesRemoved = entitiesRemoved.load(std::memory_order_relaxed);
+    return ret;
+}
+
+Instrumentation::counters_t Instrumentation::getThreadTotals() {
+    counters_t ret;
+    ret.allocations = threadAllocations;
+    ret.bytes = threadAllocationBytes;
+    ret.entitiesAdded = threadEntitiesAdded;
+    ret.entitiesRemoved = threadEntitiesRemoved;
+    return ret;
+}
+
+void Instrumentation::countEntityAdded() {
+    entitiesAdded.fetch_add(1, std::memory_order_relaxed);
+    threadEntitiesAdded++;
+}
+
+void Instrumentation::countEntityRemoved() {
+    entitiesRemoved.fetch_add(1, std::memory_order_relaxed);
+    threadEntitiesRemoved++;
+}
+
+}
+}
+
+// the array and nothrow forms, and the sized deletes, all end up in these two
+void *operator new(size_t size) {
+    Hilltop::Game::allocations.fetch_add(1, std::memory_order_relaxed);
+    Hilltop::Game::allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    Hilltop::Game::threadAllocations++;
+    Hilltop::Game::threadAllocationBytes += size;
+
+    void *ret = std::malloc(size ? size : 1);
+    if (!ret)
+        throw std::bad_alloc();
+    return ret;
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+#else
+
+Instrumentation::counters_t Instrumentation::getTotals() {
+    return counters_t();
+}
+
+Instrumentation::counters_t Instrumentation::getThreadTotals() {
+    return counters_t();
+}
+
+void Instrumentation::countEntityAdded() {}
+
+void Instrumentation::countEntityRemoved() {}
+
+}
+}
+
+#endif
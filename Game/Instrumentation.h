@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <typeindex>
+
+
+namespace Hilltop {
+namespace Game {
+
+// Counters for what the game does behind the scenes, only kept in builds with HILLTOP_INSTRUMENT
+// defined. Allocations are counted by replacing the global operator new, so they include
+// everything on every thread. Without it everything reads as 0.
+class Instrumentation {
+public:
+#ifdef HILLTOP_INSTRUMENT
+    static const bool ENABLED = true;
+#else
+    static const bool ENABLED = false;
+#endif
+
+    struct counters_t {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+        uint64_t entitiesAdded = 0;
+        uint64_t entitiesRemoved = 0;
+
+        counters_t operator-(const counters_t &other) const;
+    };
+
+    // what a match did during its last tick, on the thread it ticked on
+    struct tick_t {
+        counters_t counters;
+        // the entities left once the tick was over, by type. Types that are gone stay in at 0, so
+        // a steady tick doesn't allocate to count them.
+        std::map<std::type_index, int> liveEntities;
+    };
+
+    // since the program started, on every thread together
+    static counters_t getTotals();
+    // since the calling thread started, so other threads working at the same time don't count
+    static counters_t getThreadTotals();
+
+    // called by the match whenever it actually adds or removes one
+    static void countEntityAdded();
+    static void countEntityRemoved();
+
+    // the name of a class without its namespace
+    static std::string getTypeName(std::type_index type);
+};
+
+}
+}
@@ -0,0 +1,78 @@
+#include "Game/LatencyHistogram.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+
+namespace Hilltop {
+namespace Game {
+
+int LatencyHistogram::getBucket(uint64_t value) {
+    if (value < SUB_BUCKETS)
+        return (int)value;
+
+    // small values get a bucket each, past that the top SUB_BUCKET_BITS bits pick one
+    int shift = 0;
+    while (value >> shift >= SUB_BUCKETS)
+        shift++;
+    return (int)(shift * HALF_SUB_BUCKETS + (value >> shift));
+}
+
+uint64_t LatencyHistogram::getBucketEnd(int bucket) {
+    if (bucket < (int)SUB_BUCKETS)
+        return bucket;
+
+    const int shift = (int)(bucket / HALF_SUB_BUCKETS) - 1;
+    const uint64_t sub = bucket % HALF_SUB_BUCKETS + HALF_SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds value) {
+    const uint64_t ns = (uint64_t)std::max<int64_t>(value.count(), 0);
+    counts[getBucket(ns)]++;
+    count++;
+    max = std::max(max, ns);
+}
+
+void LatencyHistogram::reset() {
+    counts.fill(0);
+    count = 0;
+    max = 0;
+}
+
+uint64_t LatencyHistogram::getCount() const {
+    return count;
+}
+
+std::chrono::nanoseconds LatencyHistogram::getMax() const {
+    return std::chrono::nanoseconds(max);
+}
+
+std::chrono::nanoseconds LatencyHistogram::getPercentile(double percentile) const {
+    if (count == 0)
+        return std::chrono::nanoseconds::zero();
+
+    const uint64_t rank = std::max<uint64_t>(1, (uint64_t)(percentile / 100.0 * count + 0.5));
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank)
+            return std::chrono::nanoseconds(std::min(getBucketEnd(i), max));
+    }
+    return std::chrono::nanoseconds(max);
+}
+
+std::string LatencyHistogram::getSummary() const {
+    auto ms = [](std::chrono::nanoseconds value)->double {
+        return std::chrono::duration<double, std::milli>(value).count();
+    };
+
+    std::ostringstream ret;
+    ret << std::fixed << std::setprecision(2) << "p50 " << ms(getPercentile(50)) << "ms p90 " <<
+        ms(getPercentile(90)) << "ms p99 " << ms(getPercentile(99)) << "ms max " << ms(getMax()) <<
+        "ms";
+    return ret.str();
+}
+
+}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+
+namespace Hilltop {
+namespace Game {
+
+// Counts durations into buckets that get wider as they go up, each 1/32 of the values it starts at,
+// so percentiles come out within about 3% from a nanosecond to hundreds of years. Recording never
+// allocates, and the whole histogram is a fixed-size array.
+class LatencyHistogram {
+public:
+    void record(std::chrono::nanoseconds value);
+    void reset();
+
+    uint64_t getCount() const;
+    std::chrono::nanoseconds getMax() const;
+    // the value percentile percent of everything recorded is at or below, rounded up to the end of
+    // its bucket but never past the largest one recorded
+    std::chrono::nanoseconds getPercentile(double percentile) const;
+    // p50, p90, p99 and max in milliseconds
+    std::string getSummary() const;
+
+private:
+    static const int SUB_BUCKET_BITS = 6;
+    static const uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const uint64_t HALF_SUB_BUCKETS = SUB_BUCKETS / 2;
+    static const int NUM_BUCKETS = (66 - SUB_BUCKET_BITS) * HALF_SUB_BUCKETS;
+
+    std::array<uint64_t, NUM_BUCKETS> counts = {};
+    uint64_t count = 0;
+    uint64_t max = 0;
+
+    static int getBucket(uint64_t value);
+    // the largest value that goes in the bucket
+    static uint64_t getBucketEnd(int bucket);
+};
+
+}
+}
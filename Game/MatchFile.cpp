@@ -0,0 +1,172 @@
+#include "Game/MatchFile.h"
+#include "Game/Base64Buffer.h"
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/serialization/base_object.hpp>
+#include <boost/serialization/deque.hpp>
+#include <boost/serialization/export.hpp>
+#include <boost/serialization/queue.hpp>
+#include <boost/serialization/set.hpp>
+#include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/utility.hpp>
+#include <boost/serialization/vector.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Game/Entity.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::Entity)
+
+#include "Game/BotAttempt.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::BotAttempt)
+
+#include "Game/SimpleRocket.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::SimpleRocket)
+
+#include "Game/SimpleTrailedRocket.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::SimpleTrailedRocket)
+
+#include "Game/GroundTrailedRocket.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::GroundTrailedRocket)
+
+#include "Game/BouncyTrailedRocket.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::BouncyTrailedRocket)
+
+#include "Game/RocketTrail.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::RocketTrail)
+
+#include "Game/Explosion.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::Explosion)
+
+#include "Game/Tracer.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::Tracer)
+
+#include "Game/TankWheel.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::TankWheel)
+
+#include "Game/Tank.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::Tank)
+
+#include "Game/Drop.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::Drop)
+
+#include "Game/HealthDrop.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::HealthDrop)
+
+#include "Game/ArmorDrop.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::ArmorDrop)
+
+#include "Game/WeaponDrop.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::WeaponDrop)
+
+#include "Game/ParticleBomb.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::ParticleBomb)
+
+#include "Game/BulletRainCloud.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::BulletRainCloud)
+
+#include "Game/Minigun.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::Minigun)
+
+#include "Game/Weapon.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::Weapon)
+
+#include "Game/RocketWeapon.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::RocketWeapon)
+
+#include "Game/DirtRocketWeapon.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::DirtRocketWeapon)
+
+#include "Game/GroundRocketWeapon.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::GroundRocketWeapon)
+
+#include "Game/BouncyRocketWeapon.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::BouncyRocketWeapon)
+
+#include "Game/ParticleBombWeapon.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::ParticleBombWeapon)
+
+#include "Game/BulletRainWeapon.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::BulletRainWeapon)
+
+#include "Game/MinigunWeapon.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::MinigunWeapon)
+
+#include "Game/TracerWeapon.h"
+BOOST_CLASS_EXPORT(Hilltop::Game::TracerWeapon)
+
+#include "Game/TankController.h"
+
+
+namespace Hilltop {
+namespace Game {
+
+const char MatchFile::MAGIC[4] = { 'H', 'L', 'T', 'P' };
+
+static const std::string HTML_COMMENT_BEGIN = "<!DOCTYPE html><!-- ";
+static const std::string HTML_COMMENT_END = " -->";
+
+void MatchFile::write(std::ostream &out, const std::shared_ptr<TankMatch> &match) {
+    out.write(MAGIC, sizeof(MAGIC));
+    for (int i = 0; i < 4; i++)
+        out.put((char)((VERSION >> (i * 8)) & 0xFF));
+
+    boost::archive::binary_oarchive archive(out);
+    archive << match;
+}
+
+std::shared_ptr<TankMatch> MatchFile::read(std::istream &in) {
+    char magic[sizeof(MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (!in || !std::equal(std::begin(magic), std::end(magic), std::begin(MAGIC)))
+        throw std::runtime_error("Not a Hilltop save file");
+
+    unsigned int version = 0;
+    for (int i = 0; i < 4; i++)
+        version |= (unsigned int)(unsigned char)in.get() << (i * 8);
+    if (!in || version > VERSION)
+        throw std::runtime_error("This save file is from a newer version of Hilltop");
+
+    std::shared_ptr<TankMatch> match;
+    boost::archive::binary_iarchive archive(in);
+    archive >> match;
+    return match;
+}
+
+void MatchFile::writeHtmlHeader(std::ostream &out, const std::shared_ptr<TankMatch> &match) {
+    out << HTML_COMMENT_BEGIN;
+    {
+        Base64Encoder encoder(out);
+        std::ostream encoded(&encoder);
+        write(encoded, match);
+        encoder.finish();
+    }
+    out << HTML_COMMENT_END;
+}
+
+std::shared_ptr<TankMatch> MatchFile::load(std::istream &in) {
+    if (in.peek() == MAGIC[0])
+        return read(in);
+
+    std::string begin(HTML_COMMENT_BEGIN.size(), '\0');
+    in.read(&begin[0], begin.size());
+    if (!in || begin != HTML_COMMENT_BEGIN)
+        throw std::runtime_error("Not a Hilltop save file");
+
+    // web pages from before the binary format hold a text archive, which starts with a number
+    Base64Decoder decoder(in);
+    std::istream decoded(&decoder);
+    if (decoded.peek() == MAGIC[0])
+        return read(decoded);
+    return readText(decoded);
+}
+
+std::shared_ptr<TankMatch> MatchFile::readText(std::istream &in) {
+    std::shared_ptr<TankMatch> match;
+    boost::archive::text_iarchive archive(in);
+    archive >> match;
+    return match;
+}
+
+}
+}
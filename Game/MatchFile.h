@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Game/TankMatch.h"
+#include <iostream>
+
+
+namespace Hilltop {
+namespace Game {
+
+// Reads and writes saved matches. Saves are a short header followed by a Boost binary archive,
+// and can also be wrapped in a web page, base64-encoded inside a comment at the very top.
+// Binary archives store numbers as the machine has them, so a save only loads in builds for the
+// same platform, with the same byte order and type sizes, which is all Hilltop is built for.
+// Replays are written the same way. Seed codes are the way to share a match between platforms.
+class MatchFile {
+public:
+    static const char MAGIC[4];
+    // bumped along with the class version of anything in the archive after the header, so older
+    // builds refuse newer saves before Boost gets to them
+    static const unsigned int VERSION = 3;
+
+    static void write(std::ostream &out, const std::shared_ptr<TankMatch> &match);
+    static std::shared_ptr<TankMatch> read(std::istream &in);
+
+    // writes the comment a web page save starts with, the rest of the page is up to the caller
+    static void writeHtmlHeader(std::ostream &out, const std::shared_ptr<TankMatch> &match);
+
+    // takes either kind of save, including web pages from before the binary format, and reads it
+    // as it goes rather than all at once
+    static std::shared_ptr<TankMatch> load(std::istream &in);
+
+private:
+    static std::shared_ptr<TankMatch> readText(std::istream &in);
+};
+
+}
+}
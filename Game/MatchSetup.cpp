@@ -0,0 +1,312 @@
+#include "Game/MatchSetup.h"
+#include "Game/TankController.h"
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace Hilltop {
+namespace Game {
+
+static const std::string CODE_PREFIX = "HT";
+// codes from version 1 have no tick rate in them, they're still read as the default rate
+static const int CODE_VERSION = 2;
+// Crockford's base32, which leaves out the letters easily mistaken for digits
+static const char CODE_SYMBOLS[] = "0123456789ABCDEFGHJKMNPQRSTVWXYZ";
+static const int CODE_SYMBOL_BITS = 5;
+static const int CODE_GROUP = 5;
+static const int CODE_CHECKSUM_SYMBOLS = 2;
+
+// setups are packed into the code a few bits at a time, most fields only need a handful
+class CodeWriter {
+public:
+    void write(unsigned int value, int bits) {
+        for (int i = bits - 1; i >= 0; i--)
+            this->bits.push_back((value >> i) & 1);
+    }
+
+    // small numbers in 4 bit groups, each with a bit saying whether another one follows
+    void writeNumber(unsigned int value) {
+        while (value >= 0x10) {
+            write(0x10 | (value & 0xF), 5);
+            value >>= 4;
+        }
+        write(value, 5);
+    }
+
+    std::vector<unsigned char> getSymbols() const {
+        std::vector<unsigned char> ret((bits.size() + CODE_SYMBOL_BITS - 1) / CODE_SYMBOL_BITS);
+        for (size_t i = 0; i < bits.size(); i++)
+            ret[i / CODE_SYMBOL_BITS] |= bits[i] << (CODE_SYMBOL_BITS - 1 - i % CODE_SYMBOL_BITS);
+        return ret;
+    }
+
+private:
+    std::vector<unsigned char> bits;
+};
+
+class CodeReader {
+public:
+    CodeReader(const std::vector<unsigned char> &symbols) : symbols(symbols) {}
+
+    unsigned int read(int bits) {
+        unsigned int ret = 0;
+        for (int i = 0; i < bits; i++, pos++) {
+            if (pos / CODE_SYMBOL_BITS >= symbols.size())
+                throw std::runtime_error("The seed code is too short");
+            const int shift = CODE_SYMBOL_BITS - 1 - pos % CODE_SYMBOL_BITS;
+            ret = (ret << 1) | ((symbols[pos / CODE_SYMBOL_BITS] >> shift) & 1);
+        }
+        return ret;
+    }
+
+    unsigned int readNumber() {
+        unsigned int ret = 0;
+        for (int shift = 0; shift < 32; shift += 4) {
+            const unsigned int group = read(5);
+            ret |= (group & 0xF) << shift;
+            if (!(group & 0x10))
+                return ret;
+        }
+        throw std::runtime_error("Invalid seed code");
+    }
+
+private:
+    const std::vector<unsigned char> &symbols;
+    size_t pos = 0;
+};
+
+static unsigned int getCodeChecksum(const std::vector<unsigned char> &symbols) {
+    unsigned int hash = 2166136261u;
+    for (unsigned char symbol : symbols)
+        hash = (hash ^ symbol) * 16777619u;
+    return hash & ((1 << (CODE_SYMBOL_BITS * CODE_CHECKSUM_SYMBOLS)) - 1);
+}
+
+std::shared_ptr<TankMatch> MatchSetup::build() const {
+    std::shared_ptr<TankMatch> match = std::make_shared<TankMatch>(width, height);
+    match->rng.seed(seed);
+
+    buildMap(*match);
+
+    for (const player_t &p : players) {
+        std::shared_ptr<Tank> tank = Tank::create(p.color);
+        tank->maxHealth = p.maxHealth;
+        tank->health = tank->maxHealth;
+        tank->damage = p.damage;
+        tank->maxArmor = p.maxArmor;
+        tank->armor = tank->maxArmor;
+        match->addEntity(*tank);
+
+        std::shared_ptr<TankController> controller = TankController::create();
+        controller->tank = tank;
+        controller->isHuman = p.isHuman;
+        controller->botDifficulty = p.botDifficulty;
+        controller->team = p.team;
+        controller->movesPerTurn = p.movesPerTurn;
+        controller->movesLeft = controller->movesPerTurn;
+        match->players.push_back(controller);
+
+        for (int i = 0; i < TankController::START_WEAPONS; i++)
+            controller->addRandomWeapon(match.get());
+    }
+
+    match->isAiming = match->players[match->currentPlayer]->isHuman;
+
+    match->firingMode = firingMode;
+    match->ticksPerSecond = ticksPerSecond;
+
+    match->arrangeTanks();
+
+    return match;
+}
+
+void MatchSetup::buildMap(TankMatch &match) const {
+    std::function<float(float)> invert = [](float x)->float { return x; };
+    if (scale((float)match.random(), 0, TankMatch::RANDOM_MAX, 0, 1) >= 0.5f)
+        invert = [](float x)->float { return 1.0f - x; };
+
+    switch (mapType) {
+    case MAP_RANDOM: {
+        float f[4];
+        for (int i = 0; i < 4; i++)
+            f[i] = scale((float)match.random(), 0, TankMatch::RANDOM_MAX, 1.0f, 10.0f);
+        float a[4];
+        for (int i = 0; i < 4; i++)
+            a[i] = scale((float)match.random(), 0, TankMatch::RANDOM_MAX, -1 / f[i], 1 / f[i]);
+        float o[4];
+        for (int i = 0; i < 4; i++)
+            o[i] = scale((float)match.random(), 0, TankMatch::RANDOM_MAX, 0.0f, 6.28f);
+        match.buildMap([invert, &f, &a, &o](float x)->float {
+            float ret = 0;
+            for (int i = 0; i < 4; i++)
+                ret += a[i] * std::sinf(f[i] * invert(x) + o[i]);
+            return 0.5f + ret;
+        });
+        break;
+    }
+    case MAP_HILLSIDE:
+        match.buildMap([invert](float x)->float {
+            return (std::sinf(invert(x) * 2 - 1.4f) + 1.0f) / 2.0f + 0.1f;
+        });
+        break;
+    case MAP_HILLTOP:
+        match.buildMap([invert](float x)->float {
+            return (std::sinf(invert(x) * 2) + 0.1f) / 1.5f + 0.1f;
+        });
+        break;
+    }
+}
+
+std::string MatchSetup::toCode() const {
+    CodeWriter writer;
+    writer.write(CODE_VERSION, 4);
+    writer.write(seed, 32);
+
+    const bool defaultSize = width == TankMatch::DEFAULT_MATCH_WIDTH &&
+        height == TankMatch::DEFAULT_MATCH_HEIGHT;
+    writer.write(defaultSize, 1);
+    if (!defaultSize) {
+        writer.write(width, 16);
+        writer.write(height, 16);
+    }
+
+    writer.write(mapType, 2);
+    writer.write(firingMode, 2);
+
+    if (ticksPerSecond < TankMatch::MIN_TICKS_PER_SECOND ||
+        ticksPerSecond > TankMatch::MAX_TICKS_PER_SECOND)
+        throw std::runtime_error("This setup can't be turned into a seed code");
+    const bool defaultRate = ticksPerSecond == TankMatch::DEFAULT_TICKS_PER_SECOND;
+    writer.write(defaultRate, 1);
+    if (!defaultRate)
+        writer.write(ticksPerSecond, 6);
+
+    if (players.size() > 7)
+        throw std::runtime_error("Too many players for a seed code");
+    writer.write((unsigned int)players.size(), 3);
+    for (const player_t &p : players) {
+        if (p.team < 0 || p.team > 7 || p.botDifficulty < 0 || p.botDifficulty > 3 ||
+            p.maxHealth < 0 || p.maxArmor < 0 || p.movesPerTurn < 0)
+            throw std::runtime_error("This setup can't be turned into a seed code");
+        writer.write(p.team, 3);
+        writer.write(p.color, 4);
+        writer.write(p.isHuman, 1);
+        writer.write(p.botDifficulty, 2);
+        writer.writeNumber(p.maxHealth);
+
+        // the damage multipliers the menu makes are whole percentages, anything else is kept
+        // as is so the code still builds the exact same match
+        const long percent = std::lround(p.damage * 100.0f);
+        const bool isPercent = percent >= 0 && percent / 100.0f == p.damage;
+        writer.write(isPercent, 1);
+        if (isPercent) {
+            writer.writeNumber((unsigned int)percent);
+        } else {
+            unsigned int bits;
+            std::memcpy(&bits, &p.damage, sizeof(bits));
+            writer.write(bits, 32);
+        }
+
+        writer.writeNumber(p.maxArmor);
+        writer.writeNumber(p.movesPerTurn);
+    }
+
+    std::vector<unsigned char> symbols = writer.getSymbols();
+    const unsigned int checksum = getCodeChecksum(symbols);
+    for (int i = CODE_CHECKSUM_SYMBOLS - 1; i >= 0; i--)
+        symbols.push_back((checksum >> (i * CODE_SYMBOL_BITS)) & ((1 << CODE_SYMBOL_BITS) - 1));
+
+    std::string ret = CODE_PREFIX;
+    for (size_t i = 0; i < symbols.size(); i++) {
+        if (i % CODE_GROUP == 0)
+            ret += '-';
+        ret += CODE_SYMBOLS[symbols[i]];
+    }
+    return ret;
+}
+
+MatchSetup MatchSetup::fromCode(const std::string &code) {
+    std::string text;
+    for (char c : code)
+        if (!std::isspace((unsigned char)c) && c != '-')
+            text += (char)std::toupper((unsigned char)c);
+    if (text.compare(0, CODE_PREFIX.size(), CODE_PREFIX) != 0)
+        throw std::runtime_error("This is not a Hilltop seed code");
+
+    std::vector<unsigned char> symbols;
+    for (size_t i = CODE_PREFIX.size(); i < text.size(); i++) {
+        char c = text[i];
+        // the letters Crockford's base32 leaves out are read as the digits they look like
+        if (c == 'O')
+            c = '0';
+        else if (c == 'I' || c == 'L')
+            c = '1';
+        const char *symbol = std::strchr(CODE_SYMBOLS, c);
+        if (!c || !symbol)
+            throw std::runtime_error("The seed code has a character it can't have in it");
+        symbols.push_back((unsigned char)(symbol - CODE_SYMBOLS));
+    }
+
+    if (symbols.size() <= CODE_CHECKSUM_SYMBOLS)
+        throw std::runtime_error("The seed code is too short");
+    unsigned int checksum = 0;
+    for (int i = 0; i < CODE_CHECKSUM_SYMBOLS; i++)
+        checksum = (checksum << CODE_SYMBOL_BITS) |
+            symbols[symbols.size() - CODE_CHECKSUM_SYMBOLS + i];
+    symbols.resize(symbols.size() - CODE_CHECKSUM_SYMBOLS);
+    if (checksum != getCodeChecksum(symbols))
+        throw std::runtime_error("The seed code has a typo in it");
+
+    CodeReader reader(symbols);
+    const unsigned int version = reader.read(4);
+    if (version < 1 || version > CODE_VERSION)
+        throw std::runtime_error("The seed code is from a different version of Hilltop");
+
+    MatchSetup ret;
+    ret.seed = reader.read(32);
+    if (!reader.read(1)) {
+        ret.width = (unsigned short)reader.read(16);
+        ret.height = (unsigned short)reader.read(16);
+    }
+
+    ret.mapType = (MapType)reader.read(2);
+    ret.firingMode = (TankMatch::FiringMode)reader.read(2);
+    if (ret.mapType > MAP_HILLTOP || ret.firingMode > TankMatch::FIRE_EVERYTHING)
+        throw std::runtime_error("Invalid seed code");
+
+    if (version >= 2 && !reader.read(1)) {
+        ret.ticksPerSecond = reader.read(6);
+        if (ret.ticksPerSecond < TankMatch::MIN_TICKS_PER_SECOND ||
+            ret.ticksPerSecond > TankMatch::MAX_TICKS_PER_SECOND)
+            throw std::runtime_error("Invalid seed code");
+    }
+
+    ret.players.resize(reader.read(3));
+    for (player_t &p : ret.players) {
+        p.team = reader.read(3);
+        p.color = (Console::ConsoleColor)reader.read(4);
+        p.isHuman = reader.read(1) != 0;
+        p.botDifficulty = reader.read(2);
+        p.maxHealth = reader.readNumber();
+        if (reader.read(1)) {
+            p.damage = reader.readNumber() / 100.0f;
+        } else {
+            const unsigned int bits = reader.read(32);
+            std::memcpy(&p.damage, &bits, sizeof(bits));
+        }
+        p.maxArmor = reader.readNumber();
+        p.movesPerTurn = reader.readNumber();
+    }
+
+    if (ret.players.size() < 2 || ret.width < TankMatch::MIN_MATCH_WIDTH ||
+        ret.width > TankMatch::MAX_MATCH_WIDTH || ret.height < TankMatch::MIN_MATCH_HEIGHT ||
+        ret.height > TankMatch::MAX_MATCH_HEIGHT)
+        throw std::runtime_error("Invalid seed code");
+
+    return ret;
+}
+
+}
+}
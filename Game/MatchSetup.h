@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Game/TankMatch.h"
+#include <boost/serialization/vector.hpp>
+
+
+namespace Hilltop {
+namespace Game {
+
+// Everything a new match is built from. Building the same setup twice gives the same match, down
+// to the weapons everyone starts with.
+class MatchSetup {
+public:
+    enum MapType {
+        MAP_RANDOM,
+        MAP_HILLSIDE,
+        MAP_HILLTOP
+    };
+
+    struct player_t {
+        friend class boost::serialization::access;
+        template<class Archive>
+        void serialize(Archive &ar, const unsigned int version) {
+            ar & team;
+            ar & color;
+            ar & isHuman;
+            ar & botDifficulty;
+            ar & maxHealth;
+            ar & damage;
+            ar & maxArmor;
+            ar & movesPerTurn;
+        }
+
+        int team = 1;
+        Console::ConsoleColor color = Console::BLACK;
+        bool isHuman = true;
+        int botDifficulty = 0;
+        int maxHealth = 100;
+        float damage = 1.0f;
+        int maxArmor = 0;
+        int movesPerTurn = 25;
+    };
+
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive &ar, const unsigned int version) {
+        ar & seed;
+        ar & width;
+        ar & height;
+        ar & mapType;
+        ar & firingMode;
+        ar & players;
+
+        if (version >= 1)
+            ar & ticksPerSecond;
+    }
+
+    unsigned int seed = 0;
+    unsigned short width = TankMatch::DEFAULT_MATCH_WIDTH;
+    unsigned short height = TankMatch::DEFAULT_MATCH_HEIGHT;
+    MapType mapType = MAP_HILLSIDE;
+    TankMatch::FiringMode firingMode = TankMatch::FIRE_AS_TEAM;
+    std::vector<player_t> players;
+    int ticksPerSecond = TankMatch::DEFAULT_TICKS_PER_SECOND;
+
+    std::shared_ptr<TankMatch> build() const;
+
+    // a short code like HT-XXXXX-XXXXX-... that fromCode() turns back into the same setup, for
+    // sharing a map without sending a save file. fromCode() throws on codes for matches the new
+    // game screen couldn't have set up, such as sizes outside TankMatch's limits
+    std::string toCode() const;
+    static MatchSetup fromCode(const std::string &code);
+
+private:
+    void buildMap(TankMatch &match) const;
+};
+
+}
+}
+
+BOOST_CLASS_VERSION(Hilltop::Game::MatchSetup, 1)
@@ -17,15 +17,34 @@ std::shared_ptr<Minigun> Minigun::create() {
     return std::shared_ptr<Minigun>(new Minigun());
 }
 
+std::shared_ptr<Entity> Minigun::clone() {
+    return std::shared_ptr<Minigun>(new Minigun(*this));
+}
+
+bool Minigun::copyFrom(const Entity &other) {
+    *this = static_cast<const Minigun &>(other);
+    return true;
+}
+
+void Minigun::relink(const clone_map_t &clones) {
+    Entity::relink(clones);
+
+    tank = relinked(clones, tank);
+}
+
 void Minigun::onTick(TankMatch *match) {
     Entity::onTick(match);
 
-    int offset = scale(rand(), 0, RAND_MAX, -ANGLE_OFFSET - 1, ANGLE_OFFSET);
+    // one rocket every tick at the default rate
+    if (!match->countDue(entityAge, 1))
+        return;
+
+    int offset = scale(match->random(), 0, TankMatch::RANDOM_MAX, -ANGLE_OFFSET - 1, ANGLE_OFFSET);
     std::shared_ptr<SimpleRocket> rocket = SimpleRocket::create(Console::YELLOW);
-    rocket->explosionSize = 3;
+    rocket->explosionSize = EXPLOSION_SIZE;
     rocket->position = tank->getBarrelBase() + Tank::getProjectileBase(tank->angle + offset);
     rocket->direction = Tank::calcTrajectory(tank->angle + offset, tank->power);
-    rocket->explosionDamage = 0.3f;
+    rocket->explosionDamage = EXPLOSION_DAMAGE;
     match->addEntity(*rocket);
 }
 
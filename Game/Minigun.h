@@ -22,11 +22,16 @@ protected:
 public:
     static const int MINIGUN_TICKS = 32;
     static const int ANGLE_OFFSET = 3;
+    static const int EXPLOSION_SIZE = 3;
+    static constexpr float EXPLOSION_DAMAGE = 0.3f;
 
     std::shared_ptr<Tank> tank;
 
     static std::shared_ptr<Minigun> create();
 
+    virtual std::shared_ptr<Entity> clone() override;
+    virtual bool copyFrom(const Entity &other) override;
+    virtual void relink(const clone_map_t &clones) override;
     virtual void onTick(TankMatch *match) override;
 };
 
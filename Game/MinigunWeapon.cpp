@@ -15,5 +15,14 @@ void MinigunWeapon::fire(TankMatch &match, int playerNumber) {
     match.addEntity(*minigun);
 }
 
+Weapon::profile_t MinigunWeapon::getProfile() {
+    profile_t profile;
+    profile.kind = profile_t::MINIGUN;
+    profile.numRockets = Minigun::MINIGUN_TICKS;
+    profile.explosionSize = Minigun::EXPLOSION_SIZE;
+    profile.explosionDamage = Minigun::EXPLOSION_DAMAGE;
+    return profile;
+}
+
 }
 }
@@ -18,6 +18,7 @@ public:
     MinigunWeapon();
 
     virtual void fire(TankMatch &match, int playerNumber) override;
+    virtual profile_t getProfile() override;
 };
 
 }
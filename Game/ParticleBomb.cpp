@@ -15,6 +15,15 @@ std::shared_ptr<ParticleBomb> ParticleBomb::create() {
     return std::shared_ptr<ParticleBomb>(new ParticleBomb());
 }
 
+std::shared_ptr<Entity> ParticleBomb::clone() {
+    return std::shared_ptr<ParticleBomb>(new ParticleBomb(*this));
+}
+
+bool ParticleBomb::copyFrom(const Entity &other) {
+    *this = static_cast<const ParticleBomb &>(other);
+    return true;
+}
+
 void ParticleBomb::onTick(TankMatch *match) {
     SimpleTrailedRocket::onTick(match);
 
@@ -28,9 +37,9 @@ void ParticleBomb::onTick(TankMatch *match) {
                     std::shared_ptr<SimpleTrailedRocket> rocket =
                         SimpleTrailedRocket::create(Console::WHITE, Console::DARK_GRAY, 3);
                     rocket->position = position.round();
-                    rocket->direction = Tank::calcTrajectory(angle, 10);
-                    rocket->explosionSize = 3;
-                    rocket->explosionDamage = 0.6f;
+                    rocket->direction = Tank::calcTrajectory(angle, PARTICLE_POWER);
+                    rocket->explosionSize = PARTICLE_EXPLOSION_SIZE;
+                    rocket->explosionDamage = PARTICLE_DAMAGE;
                     match->addEntity(*rocket);
                 }
                 onHit(match);
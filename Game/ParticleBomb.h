@@ -22,9 +22,15 @@ public:
     static const int TRIGGER_DISTANCE_X = 40;
     static const int TRIGGER_DISTANCE_Y = 8;
     static const int STEPS = 18;
+    static const int PARTICLE_POWER = 10;
+    static const int PARTICLE_EXPLOSION_SIZE = 3;
+    static constexpr float PARTICLE_DAMAGE = 0.6f;
 
     static std::shared_ptr<ParticleBomb> create();
 
+    virtual std::shared_ptr<Entity> clone() override;
+    virtual bool copyFrom(const Entity &other) override;
+
     int team = -1;
 
     virtual void onTick(TankMatch *match) override;
@@ -18,5 +18,14 @@ void ParticleBombWeapon::fire(TankMatch &match, int playerNumber) {
     match.addEntity(*bomb);
 }
 
+Weapon::profile_t ParticleBombWeapon::getProfile() {
+    profile_t profile;
+    profile.kind = profile_t::PARTICLE_BOMB;
+    profile.numRockets = ParticleBomb::STEPS;
+    profile.explosionSize = ParticleBomb::PARTICLE_EXPLOSION_SIZE;
+    profile.explosionDamage = ParticleBomb::PARTICLE_DAMAGE;
+    return profile;
+}
+
 }
 }
@@ -0,0 +1,175 @@
+#include "Game/Profiler.h"
+#include <atomic>
+#include <iomanip>
+
+
+namespace Hilltop {
+namespace Game {
+
+const char *const Profiler::SECTION_NAMES[NUM_SECTIONS] = {
+    "tick",
+    "onTick",
+    "entity changes",
+    "physics",
+    "land physics",
+    "explosion",
+    "applyAI",
+    "match draw",
+    "UI draw",
+    "commit",
+};
+
+#ifdef HILLTOP_PROFILE
+
+// a slot is only read when its sequence is the same before and after reading it, and matches the
+// event that was meant to be there, so a write in progress or one that wrapped around is skipped
+struct slot_t {
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> frame;
+    std::atomic<int64_t> start;
+    std::atomic<int64_t> duration;
+    std::atomic<unsigned int> info;
+};
+
+static slot_t ring[Profiler::RING_SIZE];
+static std::atomic<uint64_t> nextEvent(0);
+static std::atomic<uint64_t> frameNumber(0);
+static std::atomic<int64_t> frameTotals[Profiler::NUM_SECTIONS];
+static std::atomic<int64_t> lastFrameTotals[Profiler::NUM_SECTIONS];
+static std::atomic<unsigned int> nextThread(0);
+static const Profiler::clock_t::time_point epoch = Profiler::clock_t::now();
+
+static unsigned int getThread() {
+    thread_local const unsigned int thread = nextThread++;
+    return thread;
+}
+
+Profiler::Scope::Scope(Section section, bool enabled)
+    : section(section), enabled(enabled),
+    start(enabled ? clock_t::now() : clock_t::time_point()) {}
+
+Profiler::Scope::~Scope() {
+    if (enabled)
+        record(section, start, clock_t::now());
+}
+
+void Profiler::record(Section section, clock_t::time_point start, clock_t::time_point end) {
+    const int64_t duration =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    frameTotals[section].fetch_add(duration, std::memory_order_relaxed);
+
+    const uint64_t i = nextEvent.fetch_add(1, std::memory_order_relaxed);
+    slot_t &slot = ring[i % RING_SIZE];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.frame.store(frameNumber.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    slot.start.store(std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch).count(),
+        std::memory_order_relaxed);
+    slot.duration.store(duration, std::memory_order_relaxed);
+    slot.info.store(getThread() << 8 | section, std::memory_order_relaxed);
+    slot.sequence.store(i + 1, std::memory_order_release);
+}
+
+void Profiler::endFrame() {
+    for (int i = 0; i < NUM_SECTIONS; i++)
+        lastFrameTotals[i].store(frameTotals[i].exchange(0, std::memory_order_relaxed),
+            std::memory_order_relaxed);
+    frameNumber++;
+}
+
+uint64_t Profiler::getFrame() {
+    return frameNumber;
+}
+
+Profiler::clock_t::duration Profiler::getLastFrame(Section section) {
+    return std::chrono::duration_cast<clock_t::duration>(
+        std::chrono::nanoseconds(lastFrameTotals[section].load(std::memory_order_relaxed)));
+}
+
+Profiler::clock_t::duration Profiler::getCurrentFrame(Section section) {
+    return std::chrono::duration_cast<clock_t::duration>(
+        std::chrono::nanoseconds(frameTotals[section].load(std::memory_order_relaxed)));
+}
+
+template<class F>
+void Profiler::forEachEvent(F callback) {
+    const uint64_t end = nextEvent.load(std::memory_order_acquire);
+    const uint64_t begin = end > RING_SIZE ? end - RING_SIZE : 0;
+
+    for (uint64_t i = begin; i < end; i++) {
+        const slot_t &slot = ring[i % RING_SIZE];
+        if (slot.sequence.load(std::memory_order_acquire) != i + 1)
+            continue;
+
+        event_t event;
+        event.frame = slot.frame.load(std::memory_order_relaxed);
+        event.start = slot.start.load(std::memory_order_relaxed);
+        event.duration = slot.duration.load(std::memory_order_relaxed);
+        const unsigned int info = slot.info.load(std::memory_order_relaxed);
+        event.thread = info >> 8;
+        event.section = (Section)(info & 0xff);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != i + 1)
+            continue;
+
+        callback(event);
+    }
+}
+
+#else
+
+Profiler::Scope::Scope(Section section, bool enabled)
+    : section(section), enabled(false), start() {}
+
+Profiler::Scope::~Scope() {}
+
+void Profiler::record(Section section, clock_t::time_point start, clock_t::time_point end) {}
+
+void Profiler::endFrame() {}
+
+uint64_t Profiler::getFrame() {
+    return 0;
+}
+
+Profiler::clock_t::duration Profiler::getLastFrame(Section section) {
+    return clock_t::duration::zero();
+}
+
+Profiler::clock_t::duration Profiler::getCurrentFrame(Section section) {
+    return clock_t::duration::zero();
+}
+
+template<class F>
+void Profiler::forEachEvent(F callback) {}
+
+#endif
+
+void Profiler::writeChromeTrace(std::ostream &out) {
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first = true;
+    forEachEvent([&out, &first](const event_t &event) {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        // timestamps are in microseconds, fractions keep the nanoseconds
+        out << "{\"name\":\"" << SECTION_NAMES[event.section] <<
+            "\",\"cat\":\"hilltop\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread <<
+            ",\"ts\":" << std::fixed << std::setprecision(3) << event.start / 1000.0 <<
+            ",\"dur\":" << event.duration / 1000.0 << ",\"args\":{\"frame\":" << event.frame <<
+            "}}";
+    });
+
+    out << "\n]}\n";
+}
+
+void Profiler::writeCsv(std::ostream &out) {
+    out << "frame,thread,section,start_ns,duration_ns\n";
+    forEachEvent([&out](const event_t &event) {
+        out << event.frame << "," << event.thread << "," << SECTION_NAMES[event.section] << "," <<
+            event.start << "," << event.duration << "\n";
+    });
+}
+
+}
+}
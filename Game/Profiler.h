@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+
+// times the rest of the enclosing block as the given section, in builds with HILLTOP_PROFILE
+// defined, and compiles to nothing otherwise. Takes an optional condition for when to time it, and
+// only one can be used per block.
+#ifdef HILLTOP_PROFILE
+#define HILLTOP_PROFILE_SCOPE(...) ::Hilltop::Game::Profiler::Scope profilerScope(__VA_ARGS__)
+#else
+#define HILLTOP_PROFILE_SCOPE(...)
+#endif
+
+
+namespace Hilltop {
+namespace Game {
+
+// Collects how long each part of a tick and of drawing takes. Every timed section is written to a
+// fixed-size ring without locking, from any thread, and the oldest ones are overwritten once it
+// fills up. What the ring still holds can be written out as a Chrome trace or as CSV, and the
+// totals of the last frame are kept for showing while playing.
+class Profiler {
+public:
+#ifdef HILLTOP_PROFILE
+    static const bool ENABLED = true;
+#else
+    static const bool ENABLED = false;
+#endif
+
+    typedef std::chrono::steady_clock clock_t;
+
+    enum Section : unsigned char {
+        TICK,
+        ENTITY_ON_TICK,
+        ENTITY_CHANGES,
+        ENTITY_PHYSICS,
+        LAND_PHYSICS,
+        EXPLOSION,
+        APPLY_AI,
+        MATCH_DRAW,
+        UI_DRAW,
+        COMMIT,
+        NUM_SECTIONS,
+    };
+
+    static const char *const SECTION_NAMES[NUM_SECTIONS];
+
+    static const size_t RING_SIZE = 1 << 16;
+
+    class Scope {
+    public:
+        Scope(Section section, bool enabled = true);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        const Section section;
+        const bool enabled;
+        const clock_t::time_point start;
+    };
+
+    static void record(Section section, clock_t::time_point start, clock_t::time_point end);
+
+    // starts a new frame, the totals of the one before it are what getLastFrame() returns
+    static void endFrame();
+    static uint64_t getFrame();
+    // the time spent in a section during the last frame, on every thread together
+    static clock_t::duration getLastFrame(Section section);
+    // the same for the frame so far
+    static clock_t::duration getCurrentFrame(Section section);
+
+    // complete events of the trace_event format, which chrome://tracing and Perfetto open
+    static void writeChromeTrace(std::ostream &out);
+    static void writeCsv(std::ostream &out);
+
+private:
+    struct event_t {
+        uint64_t frame;
+        int64_t start;
+        int64_t duration;
+        unsigned int thread;
+        Section section;
+    };
+
+    // calls back with every event still in the ring, oldest first
+    template<class F>
+    static void forEachEvent(F callback);
+};
+
+}
+}
@@ -0,0 +1,247 @@
+#include "Game/Replay.h"
+#include "Game/MatchFile.h"
+#include "Game/TankController.h"
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace Hilltop {
+namespace Game {
+
+const char Replay::MAGIC[4] = { 'H', 'L', 'T', 'R' };
+
+static void writeVarint(std::vector<unsigned char> &out, uint64_t value) {
+    for (; value >= 0x80; value >>= 7)
+        out.push_back((unsigned char)(value | 0x80));
+    out.push_back((unsigned char)value);
+}
+
+static uint64_t readVarint(const std::vector<unsigned char> &in, size_t &offset) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64 && offset < in.size(); shift += 7) {
+        const unsigned char byte = in[offset++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+    throw std::runtime_error("Corrupted replay data");
+}
+
+Replay::Replay() {}
+
+Replay::Replay(const MatchSetup &setup) : setup(setup) {}
+
+bool Replay::hasValue(TankMatch::CommandType type) {
+    return type != TankMatch::COMMAND_FIRE && type != TankMatch::COMMAND_END_TURN;
+}
+
+void Replay::record(TankMatch &match, const TankMatch::command_t &command) {
+    writeVarint(log, ((match.tickNumber - lastTick) << TYPE_BITS) | command.type);
+    lastTick = match.tickNumber;
+
+    if (hasValue(command.type)) {
+        const uint32_t value = (uint32_t)command.value;
+        writeVarint(log, (value << 1) ^ (command.value < 0 ? 0xFFFFFFFF : 0));
+    }
+    commandCount++;
+
+    if (command.type == TankMatch::COMMAND_END_TURN)
+        addKeyframe(match);
+}
+
+void Replay::onTick(TankMatch &match) {
+    endTick = match.tickNumber;
+    if (hashes.empty())
+        firstHashTick = match.tickNumber;
+    hashes.push_back((uint32_t)match.getHash());
+
+    if (keyframes.empty() || match.tickNumber - keyframes.back().tick >= KEYFRAME_EVERY_TICKS)
+        addKeyframe(match);
+}
+
+void Replay::addKeyframe(TankMatch &match) {
+    keyframe_t keyframe;
+    keyframe.tick = match.tickNumber;
+    keyframe.command = commandCount;
+    keyframe.snapshot = match.fork(true);
+    keyframes.push_back(keyframe);
+}
+
+std::string Replay::keyframe_t::getState() const {
+    if (!snapshot)
+        return state;
+
+    std::ostringstream out;
+    MatchFile::write(out, snapshot);
+    return out.str();
+}
+
+std::shared_ptr<TankMatch> Replay::keyframe_t::restore() const {
+    std::istringstream in(getState());
+    return MatchFile::read(in);
+}
+
+std::vector<Replay::entry_t> Replay::getCommands() const {
+    std::vector<entry_t> ret;
+    uint64_t tick = 0;
+    for (size_t offset = 0; offset < log.size();) {
+        const uint64_t header = readVarint(log, offset);
+        entry_t entry;
+        tick += header >> TYPE_BITS;
+        entry.tick = tick;
+        entry.command.type = (TankMatch::CommandType)(header & ((1 << TYPE_BITS) - 1));
+        entry.command.value = 0;
+        if (entry.command.type >= TankMatch::NUM_COMMAND_TYPES)
+            throw std::runtime_error("Corrupted replay data");
+
+        if (hasValue(entry.command.type)) {
+            const uint32_t value = (uint32_t)readVarint(log, offset);
+            entry.command.value = (int)((value >> 1) ^ (0 - (value & 1)));
+        }
+        ret.push_back(entry);
+    }
+    return ret;
+}
+
+void Replay::write(std::ostream &out) const {
+    out.write(MAGIC, sizeof(MAGIC));
+    for (int i = 0; i < 4; i++)
+        out.put((char)((VERSION >> (i * 8)) & 0xFF));
+
+    boost::archive::binary_oarchive archive(out);
+    archive << *this;
+}
+
+std::shared_ptr<Replay> Replay::read(std::istream &in) {
+    char magic[sizeof(MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (!in || !std::equal(std::begin(magic), std::end(magic), std::begin(MAGIC)))
+        throw std::runtime_error("Not a Hilltop replay file");
+
+    unsigned int version = 0;
+    for (int i = 0; i < 4; i++)
+        version |= (unsigned int)(unsigned char)in.get() << (i * 8);
+    if (!in || version > VERSION)
+        throw std::runtime_error("This replay file is from a newer version of Hilltop");
+
+    std::shared_ptr<Replay> replay = std::make_shared<Replay>();
+    boost::archive::binary_iarchive archive(in);
+    archive >> *replay;
+    if (replay->setup.players.empty())
+        throw std::runtime_error("Corrupted replay data");
+    return replay;
+}
+
+ReplayPlayer::ReplayPlayer(std::shared_ptr<const Replay> replay, bool headless)
+    : replay(replay), headless(headless), commands(replay->getCommands()) {
+    for (const Replay::keyframe_t &keyframe : replay->keyframes)
+        if (keyframe.command > commands.size())
+            throw std::runtime_error("Corrupted replay data");
+
+    match = replay->setup.build();
+    match->headless = headless;
+}
+
+bool ReplayPlayer::step() {
+    for (; nextCommand < commands.size() && commands[nextCommand].tick <= match->tickNumber;
+        nextCommand++) {
+        const TankMatch::command_t &command = commands[nextCommand].command;
+        // the match would have to have gone back in time for a command to be late
+        if (commands[nextCommand].tick < match->tickNumber)
+            throw std::runtime_error("Corrupted replay data");
+
+        // a match that went its own way can end up with commands that make no sense for it
+        if (canApply(command)) {
+            match->doCommand(command);
+        } else if (!desynced) {
+            desynced = true;
+            desyncTick = match->tickNumber;
+        }
+    }
+
+    if (isFinished())
+        return false;
+    match->tick();
+    checkHash();
+    return true;
+}
+
+bool ReplayPlayer::canApply(const TankMatch::command_t &command) const {
+    switch (command.type) {
+    case TankMatch::COMMAND_MOVE:
+        return match->canMove(command.value);
+    case TankMatch::COMMAND_WEAPON:
+        return command.value >= 0 &&
+            command.value < match->players[match->currentPlayer]->weapons.size();
+    case TankMatch::COMMAND_FIRE:
+    case TankMatch::COMMAND_END_TURN:
+        for (const std::shared_ptr<TankController> &player : match->players)
+            if (player->currentWeapon >= player->weapons.size())
+                return false;
+        return true;
+    default:
+        return true;
+    }
+}
+
+void ReplayPlayer::checkHash() {
+    const uint64_t tick = match->tickNumber;
+    if (desynced || tick < replay->firstHashTick)
+        return;
+
+    const uint64_t index = tick - replay->firstHashTick;
+    if (index < replay->hashes.size() && replay->hashes[index] != (uint32_t)match->getHash()) {
+        desynced = true;
+        desyncTick = tick;
+    }
+}
+
+bool ReplayPlayer::isDesynced() const {
+    return desynced;
+}
+
+uint64_t ReplayPlayer::getDesyncTick() const {
+    return desyncTick;
+}
+
+bool ReplayPlayer::isFinished() const {
+    return match->gameOver ||
+        (nextCommand >= commands.size() && match->tickNumber >= replay->endTick);
+}
+
+void ReplayPlayer::seek(uint64_t tick) {
+    std::vector<Replay::keyframe_t>::const_iterator keyframe = std::upper_bound(
+        replay->keyframes.begin(), replay->keyframes.end(), tick,
+        [](uint64_t tick, const Replay::keyframe_t &keyframe)->bool {
+        return tick < keyframe.tick;
+    });
+
+    if (keyframe != replay->keyframes.begin()) {
+        --keyframe;
+        if (match->tickNumber < keyframe->tick || match->tickNumber > tick) {
+            match = keyframe->restore();
+            match->headless = headless;
+            nextCommand = (size_t)keyframe->command;
+        }
+    } else if (match->tickNumber > tick) {
+        match = replay->setup.build();
+        match->headless = headless;
+        nextCommand = 0;
+    }
+
+    while (match->tickNumber < tick && step()) {}
+}
+
+uint64_t ReplayPlayer::getEndTick() const {
+    return replay->endTick;
+}
+
+std::shared_ptr<const Replay> ReplayPlayer::getReplay() const {
+    return replay;
+}
+
+}
+}
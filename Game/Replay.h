@@ -0,0 +1,152 @@
+#pragma once
+
+#include "Game/MatchSetup.h"
+#include "Game/TankMatch.h"
+#include <boost/serialization/version.hpp>
+#include <iostream>
+
+
+namespace Hilltop {
+namespace Game {
+
+// A match recorded as the setup it was built from and every command applied to it since. Playing
+// the commands back against a match built from the same setup gives the same match again, tick for
+// tick, so the commands of a whole match only take a few kilobytes.
+class Replay {
+private:
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive &ar, const unsigned int version) {
+        ar & setup;
+        ar & endTick;
+        ar & log;
+        ar & lastTick;
+        if (version >= 1) {
+            ar & commandCount;
+            ar & keyframes;
+        }
+        if (version >= 2) {
+            ar & firstHashTick;
+            ar & hashes;
+            // taken every tenth tick, and of less of the match than getHash() is now
+            if (Archive::is_loading::value && version < 3)
+                hashes.clear();
+        }
+    }
+
+public:
+    static const char MAGIC[4];
+    // bumped along with the class version of anything in the archive after the header, the
+    // keyframes included, so older builds refuse newer replays before Boost gets to them
+    static const unsigned int VERSION = 5;
+
+    struct entry_t {
+        uint64_t tick;
+        TankMatch::command_t command;
+    };
+
+    // the whole match as it was on a tick, saved the same way as a save file
+    struct keyframe_t {
+        friend class boost::serialization::access;
+        template<class Archive>
+        void save(Archive &ar, const unsigned int version) const {
+            ar & tick;
+            ar & command;
+            const std::string state = getState();
+            ar & state;
+        }
+        template<class Archive>
+        void load(Archive &ar, const unsigned int version) {
+            ar & tick;
+            ar & command;
+            ar & state;
+            snapshot.reset();
+        }
+        BOOST_SERIALIZATION_SPLIT_MEMBER()
+
+        uint64_t tick;
+        // how many commands were recorded before it was taken
+        uint64_t command;
+        // keyframes taken while recording keep a fork of the match, which is only written out
+        // when the replay is saved or seeked through, loaded ones keep what was written
+        std::shared_ptr<TankMatch> snapshot;
+        std::string state;
+
+        std::string getState() const;
+        std::shared_ptr<TankMatch> restore() const;
+    };
+
+    // besides one at the start of every turn, so that seeking never has to simulate much
+    static const int KEYFRAME_EVERY_TICKS = 600;
+
+    MatchSetup setup;
+    // the last tick the match got to while recording
+    uint64_t endTick = 0;
+    // one varint per command holding the ticks since the previous command, shifted to make room
+    // for the command type in the low bits, then the value as a zigzag varint if it has one
+    std::vector<unsigned char> log;
+    uint64_t commandCount = 0;
+    std::vector<keyframe_t> keyframes;
+    // the low half of TankMatch::getHash() after every tick from firstHashTick on, so playback can
+    // tell the exact tick it stopped matching the recording on. Four bytes a tick, a minute of
+    // match at the default rate is under 5KB.
+    uint64_t firstHashTick = 0;
+    std::vector<uint32_t> hashes;
+
+    Replay();
+    Replay(const MatchSetup &setup);
+
+    void record(TankMatch &match, const TankMatch::command_t &command);
+    void onTick(TankMatch &match);
+    // throws if the log is cut short or has something in it that isn't a command
+    std::vector<entry_t> getCommands() const;
+
+    // a Boost binary archive, so like a save, see MatchFile, it only loads on the same platform
+    void write(std::ostream &out) const;
+    static std::shared_ptr<Replay> read(std::istream &in);
+
+private:
+    static const int TYPE_BITS = 3;
+
+    uint64_t lastTick = 0;
+
+    static bool hasValue(TankMatch::CommandType type);
+    void addKeyframe(TankMatch &match);
+};
+
+// Builds the match a replay starts from and feeds it the recorded commands as it ticks.
+class ReplayPlayer {
+public:
+    std::shared_ptr<TankMatch> match;
+
+    ReplayPlayer(std::shared_ptr<const Replay> replay, bool headless = false);
+
+    // applies whatever was recorded for the current tick and ticks once, unless the replay is over
+    bool step();
+    bool isFinished() const;
+    // replaces match with one at the given tick, simulating forward from the last keyframe before
+    // it unless that is further back than where the match is already
+    void seek(uint64_t tick);
+    uint64_t getEndTick() const;
+    std::shared_ptr<const Replay> getReplay() const;
+    // whether the match stopped matching the recording somewhere, and the first tick it was found
+    // to differ on
+    bool isDesynced() const;
+    uint64_t getDesyncTick() const;
+
+private:
+    std::shared_ptr<const Replay> replay;
+    const bool headless;
+    std::vector<Replay::entry_t> commands;
+    size_t nextCommand = 0;
+    bool desynced = false;
+    uint64_t desyncTick = 0;
+
+    bool canApply(const TankMatch::command_t &command) const;
+    void checkHash();
+};
+
+}
+}
+
+BOOST_CLASS_VERSION(Hilltop::Game::Replay, 3)
@@ -7,17 +7,33 @@ namespace Game {
 RocketTrail::RocketTrail(int maxAge, Console::ConsoleColor color) : Entity(), color(color) {
     maxEntityAge = maxAge;
     gravityMult = 0.0f;
+    end = position;
 }
 
 std::shared_ptr<RocketTrail> RocketTrail::create(int maxAge, Console::ConsoleColor color) {
     return std::shared_ptr<RocketTrail>(new RocketTrail(maxAge, color));
 }
 
+std::shared_ptr<Entity> RocketTrail::clone() {
+    return std::shared_ptr<RocketTrail>(new RocketTrail(*this));
+}
+
+bool RocketTrail::copyFrom(const Entity &other) {
+    *this = static_cast<const RocketTrail &>(other);
+    return true;
+}
+
+bool RocketTrail::isTransient() {
+    return true;
+}
+
 void RocketTrail::onDraw(TankMatch *match, Console::DoublePixelBufferedConsole &console) {
     Entity::onDraw(match, console);
 
-    Vector2 p = position.round();
-    console.set(p.X, p.Y, color);
+    foreachPixel(position, end, [this, &console](Vector2 p)->bool {
+        console.set(p.X, p.Y, color);
+        return false;
+    });
 }
 
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Game/Entity.h"
+#include <boost/serialization/version.hpp>
 
 
 namespace Hilltop {
@@ -15,6 +16,10 @@ private:
     void serialize(Archive &ar, const unsigned int version) {
         ar & boost::serialization::base_object<Entity>(*this);
         ar & color;
+        if (version >= 1)
+            ar & end;
+        else
+            end = position;
     }
 
 protected:
@@ -22,16 +27,23 @@ protected:
 
 public:
     Console::ConsoleColor color;
+    // the trail is drawn as a line from its position to here, the same place for a single pixel
+    Vector2 end;
 
     static std::shared_ptr<RocketTrail> create(int maxAge, Console::ConsoleColor color);
 
+    virtual std::shared_ptr<Entity> clone() override;
+    virtual bool copyFrom(const Entity &other) override;
+    virtual bool isTransient() override;
     virtual void onDraw(TankMatch *match, Console::DoublePixelBufferedConsole &console) override;
 };
 
 template<class Archive>
 inline void load_construct_data(Archive &ar, RocketTrail *t, const unsigned int) {
-    ::new(t) RocketTrail(0, ConsoleColor());
+    ::new(t) RocketTrail(0, Console::ConsoleColor());
 }
 
 }
 }
+
+BOOST_CLASS_VERSION(Hilltop::Game::RocketTrail, 1)
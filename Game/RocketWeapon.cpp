@@ -23,14 +23,23 @@ void RocketWeapon::fire(TankMatch &match, int playerNumber) {
     Weapon::fire(match, playerNumber);
 
     std::shared_ptr<Tank> tank = match.players[playerNumber]->tank;
-    int start = tank->angle - ((numRockets - 1) * 2) / 2;
+    int start = tank->angle - ((numRockets - 1) * SPREAD) / 2;
 
     for (int i = 0; i < numRockets; i++) {
-        Vector2 direction = tank->calcTrajectory(start + i * 2, tank->power);
+        Vector2 direction = tank->calcTrajectory(start + i * SPREAD, tank->power);
         std::shared_ptr<Entity> rocket = createRocket(tank->getProjectileBase(), direction);
         match.addEntity(*rocket);
     }
 }
 
+Weapon::profile_t RocketWeapon::getProfile() {
+    // the rockets do the damage every SimpleRocket starts with, which is also what a profile has
+    profile_t profile;
+    profile.kind = profile_t::ROCKET;
+    profile.numRockets = numRockets;
+    profile.explosionSize = explosionSize;
+    return profile;
+}
+
 }
 }
@@ -18,15 +18,19 @@ private:
     }
 
 protected:
+    // getProfile() describes what this makes without calling it, so the two have to agree
     virtual std::shared_ptr<Entity> createRocket(Vector2 position, Vector2 direction);
 
 public:
+    static const int SPREAD = 2;
+
     RocketWeapon(int numRockets);
 
     const int numRockets;
     int explosionSize = 5;
 
     virtual void fire(TankMatch &match, int playerNumber) override;
+    virtual profile_t getProfile() override;
 };
 
 template<class Archive>
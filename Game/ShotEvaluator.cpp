@@ -0,0 +1,330 @@
+#include "Game/ShotEvaluator.h"
+#include "Game/BouncyTrailedRocket.h"
+#include "Game/BulletRainCloud.h"
+#include "Game/Explosion.h"
+#include "Game/Minigun.h"
+#include "Game/ParticleBomb.h"
+#include "Game/RocketWeapon.h"
+#include "Game/Tank.h"
+
+
+namespace Hilltop {
+namespace Game {
+
+ShotEvaluator::ShotEvaluator(const TankMatch::Land &land, Vector2 gravity, int stepsPerSecond,
+    const std::vector<target_t> &targets, int team, int maxSteps)
+    : land(land), gravity(gravity), stepsPerSecond(stepsPerSecond),
+    timeStep((float)TankMatch::DEFAULT_TICKS_PER_SECOND / (float)stepsPerSecond), targets(targets),
+    team(team), maxSteps(maxSteps) {}
+
+int ShotEvaluator::toDefaultTicks(int steps) const {
+    // same as TankMatch::toDefaultTicks()
+    return (int)((int64_t)steps * TankMatch::DEFAULT_TICKS_PER_SECOND / stepsPerSecond);
+}
+
+int ShotEvaluator::addProjectile(ProjectileKind kind, Vector2 position, Vector2 direction) {
+    const int i = (int)this->position.size();
+    this->position.push_back(position);
+    this->direction.push_back(direction);
+    gravityMult.push_back(1.0f);
+    this->kind.push_back(kind);
+    groundHog.push_back(false);
+    hasHit.push_back(false);
+    finished.push_back(false);
+    exploded.push_back(false);
+    age.push_back(0);
+    bouncesLeft.push_back(kind == BOUNCY ? BouncyTrailedRocket::MAX_BOUNCES : 0);
+    firstChild.push_back(0);
+    numChildren.push_back(0);
+    active.push_back(i);
+    return i;
+}
+
+int ShotEvaluator::addFlight(ProjectileKind kind, Vector2 position, Vector2 direction) {
+    const key_t key = std::make_tuple(kind, position.X, position.Y, direction.X, direction.Y);
+    std::map<key_t, int>::iterator it = projectiles.find(key);
+    if (it != projectiles.end())
+        return it->second;
+
+    const int i = addProjectile(kind, position, direction);
+    projectiles[key] = i;
+    return i;
+}
+
+int ShotEvaluator::addShot(const Weapon::profile_t &profile, Vector2 barrelBase, int angle,
+    int power) {
+    pending_t shot;
+    shot.profile = profile;
+    shot.projectile = -1;
+
+    const Vector2 base = barrelBase + Tank::getProjectileBase(angle);
+    const Vector2 direction = Tank::calcTrajectory(angle, power);
+
+    switch (profile.kind) {
+    case Weapon::profile_t::ROCKET: {
+        const int start = angle - ((profile.numRockets - 1) * RocketWeapon::SPREAD) / 2;
+        for (int i = 0; i < profile.numRockets; i++) {
+            const int a = start + i * RocketWeapon::SPREAD;
+            const int p = addFlight(ROCKET, base, Tank::calcTrajectory(a, power));
+            if (a == angle || shot.projectile == -1)
+                shot.projectile = p;
+            shot.explosions.push_back({ p, profile.explosionSize, profile.explosionDamage });
+        }
+        break;
+    }
+    case Weapon::profile_t::BOUNCY:
+    case Weapon::profile_t::GROUND:
+        shot.projectile = addFlight(profile.kind == Weapon::profile_t::BOUNCY ? BOUNCY : GROUND,
+            base, direction);
+        shot.explosions.push_back({ shot.projectile, profile.explosionSize, profile.explosionDamage });
+        break;
+    case Weapon::profile_t::PARTICLE_BOMB:
+        shot.projectile = addFlight(PARTICLE_BOMB, base, direction);
+        break;
+    case Weapon::profile_t::MINIGUN:
+        // the minigun picks a random offset every tick, spread the rockets evenly instead
+        for (int i = 0; i < profile.numRockets; i++) {
+            const int offset = (int)scale(i, 0, std::max(1, profile.numRockets - 1),
+                -Minigun::ANGLE_OFFSET - 1, Minigun::ANGLE_OFFSET);
+            const int p = addFlight(ROCKET, barrelBase + Tank::getProjectileBase(angle + offset),
+                Tank::calcTrajectory(angle + offset, power));
+            if (offset == 0 || shot.projectile == -1)
+                shot.projectile = p;
+            shot.explosions.push_back({ p, profile.explosionSize, profile.explosionDamage });
+        }
+        break;
+    case Weapon::profile_t::NONE:
+        // nothing that can hit, such as tracers, evaluate() says it missed
+        break;
+    default:
+        // bullet rain clouds fly like an ordinary rocket until they hit
+        shot.projectile = addFlight(ROCKET, base, direction);
+        break;
+    }
+
+    shots.push_back(shot);
+    return (int)shots.size() - 1;
+}
+
+void ShotEvaluator::addRain(pending_t &shot) {
+    const int cloud = shot.projectile;
+    if (!exploded[cloud])
+        return;
+
+    // the cloud drops bullets at random columns under it, spread them evenly instead
+    const Vector2 p = position[cloud].round();
+    const int left = p.Y - BulletRainCloud::CLOUD_WIDTH / 2;
+    const int right = p.Y + BulletRainCloud::CLOUD_WIDTH / 2;
+    for (int i = 0; i < shot.profile.numRockets; i++) {
+        const int column = (int)scale(i, 0, std::max(1, shot.profile.numRockets - 1), left, right);
+        const int drop = addFlight(ROCKET, Vector2(-10.0f, (float)column), Vector2(0.0f, 0.0f));
+        shot.explosions.push_back({ drop, shot.profile.explosionSize, shot.profile.explosionDamage });
+    }
+}
+
+bool ShotEvaluator::run(std::chrono::steady_clock::time_point deadline) {
+    bool rained = false;
+    while (!active.empty()) {
+        while (!active.empty()) {
+            if (std::chrono::steady_clock::now() >= deadline)
+                return false;
+
+            // anything spawned during a tick only starts moving on the next one, like entities
+            // added to the match while it ticks
+            const size_t count = active.size();
+            for (size_t i = 0; i < count; i++)
+                if (!finished[active[i]])
+                    onTick(active[i]);
+            for (size_t i = 0; i < count; i++)
+                if (!finished[active[i]])
+                    step(active[i]);
+
+            active.erase(std::remove_if(active.begin(), active.end(), [this](int i)->bool {
+                return finished[i] != 0;
+            }), active.end());
+        }
+
+        if (!rained) {
+            rained = true;
+            for (pending_t &shot : shots)
+                if (shot.profile.kind == Weapon::profile_t::BULLET_RAIN)
+                    addRain(shot);
+        }
+    }
+    return true;
+}
+
+ShotEvaluator::shot_t ShotEvaluator::evaluate(int id) {
+    const pending_t &shot = shots[id];
+    const int p = shot.projectile;
+
+    shot_t ret;
+    if (p < 0)
+        return ret;
+    ret.hit = exploded[p] || numChildren[p] > 0;
+    ret.impact = position[p];
+
+    if (!shot.profile.damagesTanks)
+        return ret;
+
+    std::vector<explosion_t> explosions = shot.explosions;
+    for (int i = 0; i < numChildren[p]; i++)
+        explosions.push_back({ firstChild[p] + i, shot.profile.explosionSize, shot.profile.explosionDamage });
+
+    std::vector<int> dealt(targets.size());
+    for (const explosion_t &e : explosions) {
+        if (!exploded[e.projectile])
+            continue;
+
+        // every tank takes damage once, from its pixel closest to the center
+        const Vector2 center = position[e.projectile].round();
+        for (int i = 0; i < targets.size(); i++) {
+            float closest = (float)e.size;
+            Vector2 point;
+            for (const Vector2 &v : targets[i].pixels) {
+                float d = distance(center, v);
+                if (d < closest) {
+                    closest = d;
+                    point = v;
+                }
+            }
+            if (closest < e.size)
+                dealt[i] += Explosion::calcDamage(e.size, e.damageMult, center, point);
+        }
+    }
+
+    for (int i = 0; i < targets.size(); i++) {
+        const int damage = std::min(dealt[i], targets[i].hitPoints);
+        ret.damage += targets[i].team == team ? -damage : damage;
+    }
+
+    return ret;
+}
+
+void ShotEvaluator::finish(int i, bool explode) {
+    finished[i] = true;
+    exploded[i] = explode;
+}
+
+bool ShotEvaluator::isNearTank(Vector2 p) {
+    for (const target_t &target : targets)
+        if (distance(p, target.barrelBase) <= 5.0f)
+            return true;
+    return false;
+}
+
+void ShotEvaluator::onTick(int i) {
+    age[i]++;
+
+    if (kind[i] == GROUND) {
+        // same as GroundTrailedRocket::onTick
+        if (toDefaultTicks(age[i]) > 10 && isNearTank(position[i].round())) {
+            finish(i, true);
+            return;
+        }
+    } else if (kind[i] == PARTICLE_BOMB) {
+        // same as ParticleBomb::onTick, which also runs once more after the bomb lands
+        for (const target_t &target : targets) {
+            if (target.team != team &&
+                std::abs(position[i].X - target.barrelBase.X) < ParticleBomb::TRIGGER_DISTANCE_X &&
+                std::abs(position[i].Y - target.barrelBase.Y) < ParticleBomb::TRIGGER_DISTANCE_Y) {
+                const Vector2 p = position[i].round();
+                firstChild[i] = (int)position.size();
+                numChildren[i] = ParticleBomb::STEPS;
+                for (int j = 0; j < ParticleBomb::STEPS; j++)
+                    addProjectile(ROCKET, p, Tank::calcTrajectory(360 / ParticleBomb::STEPS * j,
+                        ParticleBomb::PARTICLE_POWER));
+                finish(i, false);
+                return;
+            }
+        }
+
+        if (hasHit[i]) {
+            finish(i, false);
+            return;
+        }
+    }
+
+    if (toDefaultTicks(age[i]) > maxSteps)
+        finish(i, false);
+}
+
+void ShotEvaluator::onHit(int i) {
+    switch (kind[i]) {
+    case GROUND: {
+        // same as GroundTrailedRocket::onHit
+        if (!hasHit[i]) {
+            hasHit[i] = true;
+            gravityMult[i] = -1.0f;
+            groundHog[i] = true;
+        } else {
+            Vector2 p = position[i].round();
+            if (p.Y >= 0 && p.Y < land.width)
+                finish(i, true);
+        }
+        break;
+    }
+    case BOUNCY: {
+        // same as BouncyTrailedRocket::onHit
+        Vector2 d = direction[i];
+        Vector2 p = position[i].round();
+        Vector2 air;
+        bool foundAir = false;
+        for (int x = -1; x <= 1; x++) {
+            for (int y = -1; y <= 1; y++) {
+                if (land.get(p.X + x, p.Y + y) == TankMatch::AIR) {
+                    Vector2 a = Vector2(x, y);
+                    if (!foundAir) {
+                        foundAir = true;
+                        air = a;
+                    } else if (distance(p, p + air) > distance(p, p + a)) {
+                        air = a;
+                        break;
+                    }
+                }
+            }
+        }
+
+        bouncesLeft[i]--;
+        if (bouncesLeft[i] <= 0 || !foundAir || isNearTank(p)) {
+            finish(i, true);
+        } else {
+            if ((air.X < 0.0f && d.X > 0.0f) || (air.X > 0.0f && d.X < 0.0f))
+                d.X *= -1.0f;
+            if ((air.Y < 0.0f && d.Y > 0.0f) || (air.Y > 0.0f && d.Y < 0.0f))
+                d.Y *= -1.0f;
+            direction[i] = d;
+            position[i] = position[i] + air;
+        }
+        break;
+    }
+    case PARTICLE_BOMB:
+        hasHit[i] = true;
+        direction[i] = { 0.0f, 0.0f };
+        break;
+    default:
+        hasHit[i] = true;
+        direction[i] = { 0.0f, 0.0f };
+        finish(i, true);
+        break;
+    }
+}
+
+void ShotEvaluator::step(int i) {
+    // same as a physics step in TankMatch::doEntityTick, every projectile has a physicsSpeed of 1
+    const Vector2 oldPos = position[i];
+    std::pair<bool, Vector2> hit = land.checkForHit(oldPos, oldPos + direction[i] * timeStep,
+        groundHog[i] != 0);
+    position[i] = hit.second;
+    if (hit.first)
+        onHit(i);
+
+    direction[i] = direction[i] + gravity * gravityMult[i] * timeStep;
+
+    Vector2 pos = position[i].round();
+    if (!finished[i] && (pos.Y < 0 || pos.Y >= land.width || pos.X > land.height + 1))
+        finish(i, false);
+}
+
+}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Game/TankMatch.h"
+#include "Game/Weapon.h"
+#include <map>
+#include <tuple>
+
+
+namespace Hilltop {
+namespace Game {
+
+// Simulates weapons against a read-only copy of the land, without creating entities. Projectiles
+// are kept as parallel arrays and advanced together, and identical flights are only traced once,
+// so evaluating many weapons from the same spot mostly reuses the same trajectories.
+class ShotEvaluator {
+public:
+    enum ProjectileKind : unsigned char {
+        ROCKET,
+        BOUNCY,
+        GROUND,
+        PARTICLE_BOMB,
+    };
+
+    struct target_t {
+        Vector2 barrelBase;
+        std::vector<Vector2> pixels;
+        int team;
+        int hitPoints;
+    };
+
+    struct shot_t {
+        int damage = 0;
+        bool hit = false;
+        Vector2 impact;
+    };
+
+    // steps as often as a match running stepsPerSecond steps, ticksPerSecond * getStepsPerTick(),
+    // maxSteps and the ages below are still in ticks at the default rate
+    ShotEvaluator(const TankMatch::Land &land, Vector2 gravity, int stepsPerSecond,
+        const std::vector<target_t> &targets, int team, int maxSteps);
+
+    // queues a weapon fired from barrelBase, returns the id to pass to evaluate()
+    int addShot(const Weapon::profile_t &profile, Vector2 barrelBase, int angle, int power);
+    // traces everything queued so far, returns false if it gave up at the deadline first
+    bool run(std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::time_point::max());
+    shot_t evaluate(int shot);
+
+private:
+    typedef std::tuple<unsigned char, float, float, float, float> key_t;
+
+    struct explosion_t {
+        int projectile;
+        int size;
+        float damageMult;
+    };
+
+    struct pending_t {
+        Weapon::profile_t profile;
+        int projectile;
+        std::vector<explosion_t> explosions;
+    };
+
+    const TankMatch::Land &land;
+    const Vector2 gravity;
+    const int stepsPerSecond;
+    const float timeStep;
+    const std::vector<target_t> &targets;
+    const int team;
+    const int maxSteps;
+
+    // projectile state, one entry per flight
+    std::vector<Vector2> position;
+    std::vector<Vector2> direction;
+    std::vector<float> gravityMult;
+    std::vector<ProjectileKind> kind;
+    std::vector<unsigned char> groundHog;
+    std::vector<unsigned char> hasHit;
+    std::vector<unsigned char> finished;
+    std::vector<unsigned char> exploded;
+    std::vector<int> age;
+    std::vector<int> bouncesLeft;
+    std::vector<int> firstChild;
+    std::vector<int> numChildren;
+
+    std::map<key_t, int> projectiles;
+    std::vector<int> active;
+    std::vector<pending_t> shots;
+
+    int addProjectile(ProjectileKind kind, Vector2 position, Vector2 direction);
+    // reuses an identical projectile if one was already added
+    int addFlight(ProjectileKind kind, Vector2 position, Vector2 direction);
+    int toDefaultTicks(int steps) const;
+    void finish(int i, bool explode);
+    void onTick(int i);
+    void onHit(int i);
+    void step(int i);
+    bool isNearTank(Vector2 p);
+    void addRain(pending_t &shot);
+};
+
+}
+}
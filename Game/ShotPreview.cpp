@@ -0,0 +1,95 @@
+#include "Game/ShotPreview.h"
+#include "Game/RocketWeapon.h"
+#include "Game/Tank.h"
+#include "Game/TankController.h"
+
+
+namespace Hilltop {
+namespace Game {
+
+bool ShotPreview::canPreview(const Weapon::profile_t &profile) {
+    switch (profile.kind) {
+    case Weapon::profile_t::ROCKET:
+    case Weapon::profile_t::BOUNCY:
+    case Weapon::profile_t::GROUND:
+        return profile.numRockets > 0;
+    default:
+        return false;
+    }
+}
+
+const std::vector<Vector2> &ShotPreview::getPath(const TankMatch::Land &land, Vector2 gravity,
+    float timeStep, const Weapon::profile_t &profile, Vector2 barrelBase, int angle, int power) {
+    if (paths.empty() || barrelBase != this->barrelBase || gravity != this->gravity ||
+        timeStep != this->timeStep || profile.kind != kind ||
+        profile.numRockets != numRockets || land.revision != landRevision) {
+        this->barrelBase = barrelBase;
+        this->gravity = gravity;
+        this->timeStep = timeStep;
+        kind = profile.kind;
+        numRockets = profile.numRockets;
+        landRevision = land.revision;
+        paths.resize(NUM_ANGLES * NUM_POWERS);
+        traced.resize(NUM_ANGLES * NUM_POWERS);
+        for (int idx : tracedIds)
+            traced[idx] = false;
+        tracedIds.clear();
+    }
+
+    if (angle < 0 || angle >= NUM_ANGLES || power < 0 || power >= NUM_POWERS) {
+        uncached.clear();
+        traceShot(uncached, land, gravity, timeStep, numRockets, barrelBase, angle, power);
+        return uncached;
+    }
+
+    const int idx = angle * NUM_POWERS + power;
+    if (!traced[idx]) {
+        paths[idx].clear();
+        traceShot(paths[idx], land, gravity, timeStep, numRockets, barrelBase, angle, power);
+        traced[idx] = true;
+        tracedIds.push_back(idx);
+    }
+    return paths[idx];
+}
+
+void ShotPreview::draw(TankMatch *match, TankController &player,
+    Console::DoublePixelBufferedConsole &console) {
+    const Weapon::profile_t profile = player.weapons[player.currentWeapon].first->getProfile();
+    if (!canPreview(profile))
+        return;
+
+    Tank &tank = *player.tank;
+    const std::vector<Vector2> &path = getPath(match->land, match->gravity, match->getTimeStep(),
+        profile, tank.getBarrelBase(), tank.angle, tank.power);
+
+    // every other point, so the land and tanks behind the path still show through
+    for (int i = 0; i < path.size(); i += 2)
+        console.set(path[i].X, path[i].Y, Console::WHITE);
+}
+
+void ShotPreview::traceShot(std::vector<Vector2> &out, const TankMatch::Land &land,
+    Vector2 gravity, float timeStep, int numRockets, Vector2 barrelBase, int angle, int power) {
+    // every rocket leaves from the end of the barrel, only their directions are spread
+    const Vector2 position = barrelBase + Tank::getProjectileBase(angle);
+    const int start = angle - ((numRockets - 1) * RocketWeapon::SPREAD) / 2;
+    for (int i = 0; i < numRockets; i++)
+        trace(out, land, gravity, timeStep, position,
+            Tank::calcTrajectory(start + i * RocketWeapon::SPREAD, power));
+}
+
+void ShotPreview::trace(std::vector<Vector2> &out, const TankMatch::Land &land, Vector2 gravity,
+    float timeStep, Vector2 position, Vector2 direction) {
+    for (int i = 0; i * timeStep < MAX_STEPS; i++) {
+        std::pair<bool, Vector2> hit = land.checkForHit(position, position + direction * timeStep);
+        position = hit.second;
+        direction = direction + gravity * timeStep;
+
+        Vector2 p = position.round();
+        out.push_back(p);
+        if (hit.first || p.Y < 0 || p.Y >= land.width || p.X > land.height + 1)
+            break;
+    }
+}
+
+}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Game/TankMatch.h"
+#include "Game/Weapon.h"
+
+
+namespace Hilltop {
+namespace Game {
+
+class TankController;
+
+// The predicted flight of the aiming player's shot, every rocket of it, up to where each first hits
+// land. Paths are kept in a table by angle and power, so stepping either one only ever traces a
+// single new flight, and stepping back to a setting already seen traces nothing. The table is
+// thrown away whenever the tank, the weapon, the land, the gravity or the tick rate changes.
+// Only weapons that fire rockets are shown, the rest don't fly like one.
+class ShotPreview {
+public:
+    // aiming above the horizon, angles past it fly into the ground and aren't kept
+    static const int NUM_ANGLES = 181;
+    static const int NUM_POWERS = 101;
+    static const int MAX_STEPS = 500;
+
+    static bool canPreview(const Weapon::profile_t &profile);
+
+    const std::vector<Vector2> &getPath(const TankMatch::Land &land, Vector2 gravity,
+        float timeStep, const Weapon::profile_t &profile, Vector2 barrelBase, int angle,
+        int power);
+    void draw(TankMatch *match, TankController &player,
+        Console::DoublePixelBufferedConsole &console);
+
+private:
+    Vector2 barrelBase;
+    Vector2 gravity;
+    float timeStep = 1.0f;
+    Weapon::profile_t::Kind kind = Weapon::profile_t::NONE;
+    int numRockets = 0;
+    unsigned int landRevision = 0;
+    std::vector<std::vector<Vector2>> paths;
+    // the path for an angle the table doesn't keep
+    std::vector<Vector2> uncached;
+    std::vector<unsigned char> traced;
+    // only the entries that were filled in get reset
+    std::vector<int> tracedIds;
+
+    // every rocket the weapon fires, spread like RocketWeapon::fire spreads them
+    static void traceShot(std::vector<Vector2> &out, const TankMatch::Land &land, Vector2 gravity,
+        float timeStep, int numRockets, Vector2 barrelBase, int angle, int power);
+    // steps like TankMatch::doEntityTick moves a rocket, using the same hit test
+    static void trace(std::vector<Vector2> &out, const TankMatch::Land &land, Vector2 gravity,
+        float timeStep, Vector2 position, Vector2 direction);
+};
+
+}
+}
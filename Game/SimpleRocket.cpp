@@ -12,6 +12,15 @@ std::shared_ptr<SimpleRocket> SimpleRocket::create(Console::ConsoleColor color)
     return std::shared_ptr<SimpleRocket>(new SimpleRocket(color));
 }
 
+std::shared_ptr<Entity> SimpleRocket::clone() {
+    return std::shared_ptr<SimpleRocket>(new SimpleRocket(*this));
+}
+
+bool SimpleRocket::copyFrom(const Entity &other) {
+    *this = static_cast<const SimpleRocket &>(other);
+    return true;
+}
+
 void SimpleRocket::onDraw(TankMatch *match, Console::DoublePixelBufferedConsole &console) {
     Entity::onDraw(match, console);
 
@@ -25,9 +25,11 @@ protected:
     SimpleRocket(Console::ConsoleColor color);
 
 public:
+    static const int DEFAULT_EXPLOSION_SIZE = 5;
+
     Console::ConsoleColor color;
 
-    int explosionSize = 5;
+    int explosionSize = DEFAULT_EXPLOSION_SIZE;
     float explosionDamage = 1.0f;
 
     bool destroyLand = true;
@@ -35,13 +37,15 @@ public:
 
     static std::shared_ptr<SimpleRocket> create(Console::ConsoleColor color);
 
+    virtual std::shared_ptr<Entity> clone() override;
+    virtual bool copyFrom(const Entity &other) override;
     virtual void onDraw(TankMatch *match, Console::DoublePixelBufferedConsole &console) override;
     virtual void onHit(TankMatch *match) override;
 };
 
 template<class Archive>
 inline void load_construct_data(Archive &ar, SimpleRocket *t, const unsigned int) {
-    ::new(t) SimpleRocket(ConsoleColor());
+    ::new(t) SimpleRocket(Console::ConsoleColor());
 }
 
 }
@@ -1,6 +1,7 @@
 #include "Game/SimpleTrailedRocket.h"
 #include "Game/RocketTrail.h"
 #include "Game/TankMatch.h"
+#include <algorithm>
 
 
 namespace Hilltop {
@@ -14,19 +15,60 @@ std::shared_ptr<SimpleTrailedRocket> SimpleTrailedRocket::create(Console::Consol
     return std::shared_ptr<SimpleTrailedRocket>(new SimpleTrailedRocket(color, trailColor, trailTime));
 }
 
+std::shared_ptr<Entity> SimpleTrailedRocket::clone() {
+    return std::shared_ptr<SimpleTrailedRocket>(new SimpleTrailedRocket(*this));
+}
+
+bool SimpleTrailedRocket::copyFrom(const Entity &other) {
+    *this = static_cast<const SimpleTrailedRocket &>(other);
+    return true;
+}
+
 void SimpleTrailedRocket::onTick(TankMatch *match) {
     SimpleRocket::onTick(match);
 
     if (!hasHit || groundHog) {
-        Vector2 from = position - match->gravity * gravityMult;
-        Vector2 to = from + direction;
+        const float timeStep = match->getTimeStep();
+        Vector2 from = position - match->gravity * gravityMult * timeStep;
+        Vector2 to = from + direction * timeStep;
         to = match->checkForHit(position, to, groundHog).second.round();
-        foreachPixel(from, to, [this, match, to](Vector2 p)->bool {
+
+        // trails are transient and don't hold a turn open, so cutting them back under load only
+        // changes what is drawn
+        if (match->degradation >= TankMatch::DEGRADE_THIN_TRAILS && !match->countDue(entityAge, 2))
+            return;
+        const int time = std::max(1, trailTime >> std::max(0, match->degradation - 1));
+
+        if (match->degradation >= TankMatch::DEGRADE_MERGE_TRAILS) {
+            bool first = true;
+            Vector2 start, end;
+            foreachPixel(from, to, [&first, &start, &end, to](Vector2 p)->bool {
+                if (p.round() == to)
+                    return true;
+
+                if (first)
+                    start = p;
+                first = false;
+                end = p;
+                return false;
+            });
+
+            if (!first) {
+                std::shared_ptr<RocketTrail> trail = RocketTrail::create(time, trailColor);
+                trail->position = start;
+                trail->end = end;
+                match->addEntity(*trail);
+            }
+            return;
+        }
+
+        foreachPixel(from, to, [this, match, to, time](Vector2 p)->bool {
             if (p.round() == to)
                 return true;
 
-            std::shared_ptr<RocketTrail> trail = RocketTrail::create(trailTime, trailColor);
+            std::shared_ptr<RocketTrail> trail = RocketTrail::create(time, trailColor);
             trail->position = p;
+            trail->end = p;
             match->addEntity(*trail);
             return false;
         });
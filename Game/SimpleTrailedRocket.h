@@ -28,12 +28,14 @@ public:
     static std::shared_ptr<SimpleTrailedRocket> create(Console::ConsoleColor color,
         Console::ConsoleColor trailColor, int trailTime);
 
+    virtual std::shared_ptr<Entity> clone() override;
+    virtual bool copyFrom(const Entity &other) override;
     virtual void onTick(TankMatch *match) override;
 };
 
 template<class Archive>
 inline void load_construct_data(Archive &ar, SimpleTrailedRocket *t, const unsigned int) {
-    ::new(t) SimpleTrailedRocket(ConsoleColor(), ConsoleColor(), 0);
+    ::new(t) SimpleTrailedRocket(Console::ConsoleColor(), Console::ConsoleColor(), 0);
 }
 
 }
@@ -1,4 +1,5 @@
 #include "Game/Tank.h"
+#include "Game/Hash.h"
 #include "Game/SimpleRocket.h"
 #include "Game/TankMatch.h"
 #include "Game/TankWheel.h"
@@ -16,6 +17,10 @@ Console::ConsoleColor Tank::getActualColor() {
 }
 
 Vector2 Tank::getBarrelBase() {
+    return getBarrelBase(position);
+}
+
+Vector2 Tank::getBarrelBase(Vector2 position) {
     return position.round() + Vector2(-2.0f, 2.0f);
 }
 
@@ -74,11 +79,15 @@ Vector2 Tank::calcTrajectory() {
 }
 
 std::vector<Vector2> Tank::getPixels() {
+    return getPixels(position, angle);
+}
+
+std::vector<Vector2> Tank::getPixels(Vector2 position, int angle) {
     std::vector<Vector2> pixels;
 
     // the barrel
-    float a = angle * PI / 180.0f;
-    foreachPixel(getBarrelBase(), getBarrelEnd(), [&pixels](Vector2 v)->bool {
+    Vector2 barrelBase = getBarrelBase(position);
+    foreachPixel(barrelBase, barrelBase + getBarrelEnd(angle), [&pixels](Vector2 v)->bool {
         pixels.push_back(v);
         return false;
     });
@@ -112,6 +121,32 @@ std::shared_ptr<Tank> Tank::create(Console::ConsoleColor color) {
     return std::shared_ptr<Tank>(new Tank(color));
 }
 
+std::shared_ptr<Entity> Tank::clone() {
+    return std::shared_ptr<Tank>(new Tank(*this));
+}
+
+bool Tank::copyFrom(const Entity &other) {
+    *this = static_cast<const Tank &>(other);
+    return true;
+}
+
+uint64_t Tank::getHash() const {
+    uint64_t ret = Entity::getHash();
+    addHash(ret, (uint64_t)alive);
+    addHash(ret, (uint64_t)health);
+    addHash(ret, (uint64_t)armor);
+    addHash(ret, (uint64_t)angle);
+    addHash(ret, (uint64_t)power);
+    return ret;
+}
+
+void Tank::relink(const clone_map_t &clones) {
+    Entity::relink(clones);
+
+    for (int i = 0; i < 5; i++)
+        wheels[i] = relinked(clones, wheels[i]);
+}
+
 void Tank::initWheels(TankMatch &match) {
     for (int i = 0; i < 5; i++) {
         if (!wheels[i])
@@ -177,41 +212,55 @@ void Tank::drawReticle(TankMatch *match, Console::DoublePixelBufferedConsole &co
 }
 
 bool Tank::canMove(TankMatch *match, int direction) {
-    Vector2 p = position;
-    doMove(match, direction);
+    return calcMove(match->land, position, direction) != position;
+}
+
+void Tank::doMove(TankMatch *match, int direction) {
+    Vector2 p = calcMove(match->land, position, direction);
     if (p != position) {
         position = p;
-        return true;
-    } else {
-        return false;
+        initWheels(*match);
     }
 }
 
-void Tank::doMove(TankMatch *match, int direction) {
+Vector2 Tank::calcMove(const TankMatch::Land &land, Vector2 position, int direction) {
     Vector2 p = position.round() + Vector2(0, direction);
-    if (p.X < 0.0f || p.X >= match->width - 5.0f)
-        return;
+    if (p.Y < 0.0f || p.Y >= land.width - 5.0f)
+        return position;
 
-    bool ret;
     for (int off = 0; off <= 3; off++) {
-        ret = true;
-        for (int i = 1; i <= 2; i++) {
+        bool ret = true;
+        for (int i = 1; i <= 2 && ret; i++) {
             for (int j = 0; j < 5; j++) {
-                if (match->get(p.X - i, p.Y + j) != TankMatch::AIR) {
+                if (land.get(p.X - i, p.Y + j) != TankMatch::AIR) {
                     ret = false;
                     break;
                 }
             }
         }
-        if (ret) {
-            position = p;
-            break;
-        }
+        if (ret)
+            return p;
         p.X--;
     }
 
-    if (ret)
-        initWheels(*match);
+    return position;
+}
+
+Vector2 Tank::calcSettled(const TankMatch::Land &land, Vector2 position) {
+    // each wheel falls until it rests on land, the tank sits on the highest one
+    Vector2 p = position.round();
+    int top = land.height;
+    for (int j = 0; j < 5; j++) {
+        int x = std::max<int>(0, p.X);
+        while (x < top && land.get(x, p.Y + j) == TankMatch::AIR)
+            x++;
+        top = std::min(top, x);
+    }
+    return Vector2(top, p.Y);
+}
+
+bool Tank::isSettled(TankMatch *match) {
+    return position.round() == calcSettled(match->land, position);
 }
 
 void Tank::dealDamage(TankMatch *match, int damage) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Game/Entity.h"
+#include "Game/TankMatch.h"
 
 
 namespace Hilltop {
@@ -47,6 +48,7 @@ public:
     float damage = 1.0f;
 
     Vector2 getBarrelBase();
+    static Vector2 getBarrelBase(Vector2 position);
     Vector2 getBarrelEnd();
     static Vector2 getBarrelEnd(int angle);
     Vector2 getProjectileBase();
@@ -56,11 +58,16 @@ public:
     static Vector2 calcTrajectory(int angle, int power);
     Vector2 calcTrajectory();
     std::vector<Vector2> getPixels();
+    static std::vector<Vector2> getPixels(Vector2 position, int angle);
     bool testCollision(Vector2 position);
 
     static std::shared_ptr<Tank> create(Console::ConsoleColor color);
     void initWheels(TankMatch &match);
 
+    virtual std::shared_ptr<Entity> clone() override;
+    virtual bool copyFrom(const Entity &other) override;
+    virtual void relink(const clone_map_t &clones) override;
+    virtual uint64_t getHash() const override;
     virtual void onTick(TankMatch *match) override;
     virtual void onDraw(TankMatch *match, Console::DoublePixelBufferedConsole &console) override;
 
@@ -68,6 +75,9 @@ public:
 
     bool canMove(TankMatch *match, int direction);
     void doMove(TankMatch *match, int direction);
+    static Vector2 calcMove(const TankMatch::Land &land, Vector2 position, int direction);
+    static Vector2 calcSettled(const TankMatch::Land &land, Vector2 position);
+    bool isSettled(TankMatch *match);
 
     void dealDamage(TankMatch *match, int damage);
     void die(TankMatch *match);
@@ -75,7 +85,7 @@ public:
 
 template<class Archive>
 inline void load_construct_data(Archive &ar, Tank *t, const unsigned int) {
-    ::new(t) Tank(ConsoleColor());
+    ::new(t) Tank(Console::ConsoleColor());
 }
 
 }
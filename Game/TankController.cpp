@@ -1,4 +1,5 @@
 #include "Game/TankController.h"
+#include "Game/Profiler.h"
 
 
 namespace Hilltop {
@@ -10,6 +11,24 @@ std::shared_ptr<TankController> TankController::create() {
     return std::shared_ptr<TankController>(new TankController());
 }
 
+std::shared_ptr<TankController> TankController::clone(const Entity::clone_map_t &clones) {
+    std::shared_ptr<TankController> ret(new TankController(*this));
+    ret->relink(clones);
+    return ret;
+}
+
+void TankController::copyFrom(const TankController &other, const Entity::clone_map_t &clones) {
+    *this = other;
+    relink(clones);
+}
+
+void TankController::relink(const Entity::clone_map_t &clones) {
+    tank = Entity::relinked(clones, tank);
+    botTargetTank = Entity::relinked(clones, botTargetTank);
+    botAttempts.clear();
+    botPlan = std::shared_future<BotPlanner::result_t>();
+}
+
 void TankController::addWeapon(std::shared_ptr<Weapon> weapon, int amount) {
     for (int i = 0; i < weapons.size(); i++) {
         if (weapons[i].first == weapon) {
@@ -21,8 +40,8 @@ void TankController::addWeapon(std::shared_ptr<Weapon> weapon, int amount) {
     weapons.push_back(std::make_pair(weapon, amount));
 }
 
-void TankController::addRandomWeapon() {
-    const int idx = rand() % TankMatch::weapons.size();
+void TankController::addRandomWeapon(TankMatch *match) {
+    const int idx = match->random() % TankMatch::weapons.size();
     addWeapon(TankMatch::weapons[idx], 1);
 }
 
@@ -33,156 +52,188 @@ int TankController::getWeaponCount() {
     return ret;
 }
 
-bool TankController::applyAI(TankMatch *match, TankController &player) {
-    if (player.botAttempts.empty()) {
-        if (player.botTargetAngle != -1 || player.botTargetPower != -1) {
-            if (player.botStepsDone < BOT_STEPS) {
-                if (player.botLastStepTick + BOT_TICKS_BETWEEN_STEPS <= match->tickNumber) {
-                    int angleDelta = player.botTargetAngle - player.tank->angle;
-                    if (angleDelta < 2)
-                        angleDelta++;
-                    player.tank->angle += angleDelta / 2;
-
-                    int powerDelta = player.botTargetPower - player.tank->power;
-                    if (powerDelta < 2)
-                        powerDelta++;
-                    player.tank->power += powerDelta / 2;
-
-                    player.botStepsDone++;
-                    player.botLastStepTick = match->tickNumber;
-                }
-            } else {
-                player.tank->angle = player.botTargetAngle;
-                player.botTargetAngle = -1;
-
-                player.tank->power = player.botTargetPower;
-                player.botTargetPower = -1;
-
-                return true;
+void TankController::chooseBotTarget(TankMatch *match) {
+    if (!botTargetTank || !botTargetTank->alive) {
+        botTargetTank.reset();
+        std::vector<std::shared_ptr<TankController>> players = match->players;
+        for (int i = 0; i < players.size(); i++) {
+            if (!players[i]->tank->alive || players[i]->team == team) {
+                players.erase(players.begin() + i);
+                i--;
             }
-        } else {
-            for (int mult = -1; mult <= 1; mult += 2) {
-                for (int i = -10; i <= 10; i++) {
-                    int angle = player.tank->angle;
-                    int angleOff;
-                    if (i >= -5 && i <= 5)
-                        angleOff = i;
-                    else
-                        angleOff = i * 4;
-                    angle = std::max(0, std::min(180, angle + angleOff * mult));
-
-                    int power = player.tank->power;
-                    if (i >= -5 && i <= 5)
-                        power += i;
-                    else
-                        power += i * 3;
-                    power = std::max(0, std::min(100, power));
-
-                    std::shared_ptr<BotAttempt> attempt = BotAttempt::create();
-                    attempt->angle = player.tank->angle;
-                    attempt->power = power;
-                    attempt->position = player.tank->getProjectileBase();
-                    attempt->direction = Tank::calcTrajectory(player.tank->angle, power);
-                    attempt->physicsSpeed = BotAttempt::enableDebug ? 1 : BOT_ATTEMPT_SPEED;
-                    attempt->maxEntityAge = BOT_MAX_ATTEMPT_TIME *
-                        (BotAttempt::enableDebug ? BOT_ATTEMPT_SPEED : 1);
-                    player.botAttempts.push_back(attempt);
-                    match->addEntity(*attempt);
-                }
+        }
+        if (!players.empty()) {
+            std::sort(players.begin(), players.end(),
+                [](std::shared_ptr<TankController> x, std::shared_ptr<TankController> y)->bool {
+                return x->tank->health / 10 < y->tank->health / 10;
+            });
+            int maxEq = 0;
+            for (int i = 1; i < players.size(); i++) {
+                if (players[i]->tank->health / 10 == players[0]->tank->health / 10)
+                    maxEq = i;
+                else
+                    break;
             }
+            int idx = maxEq;
+            if (maxEq > 0)
+                idx = rand() % maxEq;
+            botTargetTank = players[idx]->tank;
+        }
+    }
 
-            for (int i = 0; i < RANDOM_ATTEMPTS_BY_BOT_DIFFICULTY[player.botDifficulty]; i++) {
-                int angle = scale(rand(), 0, RAND_MAX, 0, 180);
-                int power = scale(rand(), 0, RAND_MAX, 0, 100);
-
-                std::shared_ptr<BotAttempt> attempt = BotAttempt::create();
-                attempt->angle = angle;
-                attempt->power = power;
-                attempt->position = player.tank->getBarrelBase() + Tank::getProjectileBase(angle);
-                attempt->direction = Tank::calcTrajectory(angle, power);
-                attempt->physicsSpeed = BotAttempt::enableDebug ? 1 : BOT_ATTEMPT_SPEED;
-                attempt->maxEntityAge = BOT_MAX_ATTEMPT_TIME *
-                    (BotAttempt::enableDebug ? BOT_ATTEMPT_SPEED : 1);
-                player.botAttempts.push_back(attempt);
-                match->addEntity(*attempt);
-            }
+    if (botTargetTank) {
+        botTarget = botTargetTank->getBarrelBase();
+    } else {
+        botTarget = {
+            (float)(rand() % match->height),
+            (float)(rand() % match->width)
+        };
+    }
+}
 
-            player.currentWeapon = rand() % player.weapons.size();
-
-            player.botStepsDone = 0;
-            player.botLastStepTick = match->tickNumber;
-
-            if (!player.botTargetTank || !player.botTargetTank->alive) {
-                player.botTargetTank.reset();
-                std::vector<std::shared_ptr<TankController>> players = match->players;
-                for (int i = 0; i < players.size(); i++) {
-                    if (!players[i]->tank->alive || players[i]->team == player.team) {
-                        players.erase(players.begin() + i);
-                        i--;
-                    }
-                }
-                if (!players.empty()) {
-                    std::sort(players.begin(), players.end(),
-                        [](std::shared_ptr<TankController> x, std::shared_ptr<TankController> y)->bool {
-                        return x->tank->health / 10 < y->tank->health / 10;
-                    });
-                    int maxEq = 0;
-                    for (int i = 1; i < players.size(); i++) {
-                        if (players[i]->tank->health / 10 == players[0]->tank->health / 10)
-                            maxEq = i;
-                        else
-                            break;
-                    }
-                    int idx = maxEq;
-                    if (maxEq > 0)
-                        idx = rand() % maxEq;
-                    player.botTarget = players[idx]->tank->getBarrelBase();
-                    player.botTargetTank = players[idx]->tank;
-                }
-            }
+void TankController::planFiringGroup(TankMatch *match) {
+    // everyone whose shot goes off together plans at once, against the same copy of the land
+    std::shared_ptr<const TankMatch::Land> land = std::make_shared<TankMatch::Land>(match->land);
+    std::vector<int> planners;
+    for (int i : match->getFiringGroup()) {
+        const TankController &player = *match->players[i];
+        if (!player.isHuman && !player.botPlan.valid() &&
+            player.botTargetAngle == -1 && player.botTargetPower == -1)
+            planners.push_back(i);
+    }
 
-            if (player.botTargetTank) {
-                player.botTarget = player.botTargetTank->getBarrelBase();
-            } else {
-                player.botTarget = {
-                    (float)(rand() % match->height),
-                    (float)(rand() % match->width)
-                };
-            }
+    const int threads = BotPlanner::shareThreads((int)planners.size());
+    for (int i : planners) {
+        TankController &player = *match->players[i];
+        // players after the current one get their moves back when their turn starts
+        int moves = i == match->currentPlayer ? player.movesLeft : player.movesPerTurn;
+        moves = std::min(moves, MOVES_BY_BOT_DIFFICULTY[player.botDifficulty]);
+
+        player.chooseBotTarget(match);
+        player.startBotPlan(match, i, moves, land, threads);
+    }
+}
+
+void TankController::startBotPlan(TankMatch *match, int playerNumber, int maxMoves,
+    std::shared_ptr<const TankMatch::Land> land, int threads) {
+    BotPlanner::request_t request = BotPlanner::prepare(match, *this, maxMoves, land,
+        BotPlanner::buildShots(*this));
+    request.threads = threads;
+    if (LOOKAHEAD_BY_BOT_DIFFICULTY[botDifficulty]) {
+        request.fork = match->fork(true);
+        request.playerNumber = playerNumber;
+    }
+    botPlan = std::async(std::launch::async, [request]()->BotPlanner::result_t {
+        return BotPlanner::run(request);
+    }).share();
+}
+
+void TankController::applyPlan(TankMatch *match, const BotPlanner::result_t &result) {
+    const BotPlanner::plan_t &plan = result.best;
+    botTargetPosition = plan.position;
+    botTargetMoves = plan.moves;
+    // the weapon only gets picked once it's this player's turn to fire, until then their
+    // current weapon stays whatever it was
+    botTargetWeapon = plan.weapon >= 0 ? plan.weapon : rand() % weapons.size();
+    botTargetAngle = plan.angle;
+    botTargetPower = plan.power;
+
+    clearBotAttempts(match);
+    for (const BotPlanner::plan_t &p : result.candidates) {
+        std::shared_ptr<BotAttempt> attempt = BotAttempt::create();
+        attempt->angle = p.angle;
+        attempt->power = p.power;
+        attempt->position = p.impact;
+        attempt->physicsSpeed = 0;
+        if (p.position == plan.position && p.angle == plan.angle && p.power == plan.power)
+            attempt->color = Console::GREEN;
+        botAttempts.push_back(attempt);
+        match->addEntity(*attempt);
+    }
+}
+
+void TankController::clearBotAttempts(TankMatch *match) {
+    for (int i = 0; i < botAttempts.size(); i++)
+        match->removeEntity(*botAttempts[i]);
+    botAttempts.clear();
+}
+
+bool TankController::isBotThinking() const {
+    return botTargetAngle == -1 && botTargetPower == -1 && botPlan.valid() &&
+        botPlan.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+bool TankController::applyAI(TankMatch *match, TankController &player) {
+    HILLTOP_PROFILE_SCOPE(Profiler::APPLY_AI, !match->headless);
+    if (player.botTargetAngle == -1 && player.botTargetPower == -1) {
+        if (!player.botPlan.valid())
+            planFiringGroup(match);
+        if (player.botPlan.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return false;
+
+        player.applyPlan(match, player.botPlan.get());
+        player.botPlan = std::shared_future<BotPlanner::result_t>();
+
+        player.botStepsDone = 0;
+        player.botLastStepTick = match->tickNumber;
+        return false;
+    }
+
+    const uint64_t sinceLastStep = match->toDefaultTicks(
+        (match->tickNumber - player.botLastStepTick) * match->getStepsPerTick());
+    if (sinceLastStep < BOT_TICKS_BETWEEN_STEPS || !player.tank->isSettled(match))
+        return false;
+
+    if (player.botTargetMoves != 0) {
+        const int direction = player.botTargetMoves < 0 ? -1 : 1;
+        if (match->canMove(direction)) {
+            match->doCommand({ TankMatch::COMMAND_MOVE, direction });
+            player.botTargetMoves -= direction;
+        } else {
+            player.botTargetMoves = 0;
         }
-    } else {
-        std::sort(player.botAttempts.begin(), player.botAttempts.end(),
-            [player](std::shared_ptr<BotAttempt> x, std::shared_ptr<BotAttempt> y)->bool {
-            Vector2 p1 = x->position.round();
-            Vector2 p2 = y->position.round();
-            if (p1 != p2)
-                return distance(player.botTarget, p1) < distance(player.botTarget, p2);
-
-            int a1 = x->angle;
-            int a2 = y->angle;
-            if (a1 != a2)
-                return std::abs(player.tank->angle - a1) < std::abs(player.tank->angle - a2);
-
-            return std::abs(player.tank->power - x->power) < std::abs(player.tank->power - y->power);
-        });
-
-        player.botAttempts[0]->color = Console::GREEN;
-        for (int i = 1; i < player.botAttempts.size(); i++)
-            player.botAttempts[i]->color = Console::RED;
-
-        for (int i = 0; i < player.botAttempts.size(); i++)
-            if (!player.botAttempts[i]->hasHit && !player.botAttempts[i]->hasExpired)
-                return false;
-
-        player.botTargetAngle = player.botAttempts[0]->angle;
-        player.botTargetPower = player.botAttempts[0]->power;
-
-        for (int i = 0; i < player.botAttempts.size(); i++)
-            match->removeEntity(*player.botAttempts[i]);
-        player.botAttempts.clear();
+
+        // the land may have changed since planning, so aim again from wherever the tank ended up,
+        // on another thread like the first plan, and wait for it above
+        if (player.botTargetMoves == 0 &&
+            Tank::calcSettled(match->land, player.tank->position) != player.botTargetPosition) {
+            player.botTargetAngle = -1;
+            player.botTargetPower = -1;
+            player.botPlan = std::shared_future<BotPlanner::result_t>();
+            player.startBotPlan(match, match->currentPlayer, 0,
+                std::make_shared<TankMatch::Land>(match->land), BotPlanner::shareThreads(1));
+        }
+
+        player.botLastStepTick = match->tickNumber;
+        return false;
+    }
+
+    if (player.botStepsDone < BOT_STEPS) {
+        int angleDelta = player.botTargetAngle - player.tank->angle;
+        if (angleDelta < 2)
+            angleDelta++;
+        match->doCommand({ TankMatch::COMMAND_ANGLE, player.tank->angle + angleDelta / 2 });
+
+        int powerDelta = player.botTargetPower - player.tank->power;
+        if (powerDelta < 2)
+            powerDelta++;
+        match->doCommand({ TankMatch::COMMAND_POWER, player.tank->power + powerDelta / 2 });
+
+        player.botStepsDone++;
+        player.botLastStepTick = match->tickNumber;
+        return false;
     }
 
-    return false;
+    match->doCommand({ TankMatch::COMMAND_ANGLE, player.botTargetAngle });
+    player.botTargetAngle = -1;
+
+    match->doCommand({ TankMatch::COMMAND_POWER, player.botTargetPower });
+    player.botTargetPower = -1;
+
+    match->doCommand({ TankMatch::COMMAND_WEAPON, player.botTargetWeapon });
+
+    player.clearBotAttempts(match);
+    return true;
 }
 
 }
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "Game/BotAttempt.h"
+#include "Game/BotPlanner.h"
 #include "Game/Tank.h"
 #include "Game/TankMatch.h"
 #include "Game/Weapon.h"
+#include <boost/serialization/version.hpp>
+#include <future>
 
 
 namespace Hilltop {
@@ -14,7 +17,9 @@ private:
     friend class boost::serialization::access;
     template<class Archive>
     void serialize(Archive &ar, const unsigned int version) {
-        ar & botAttempts;
+        // bot attempts are only drawn, so saves leave them out and loads drop old ones
+        std::vector<std::shared_ptr<BotAttempt>> savedBotAttempts;
+        ar & savedBotAttempts;
         ar & botTargetTank;
         ar & botTarget;
         ar & botTargetAngle;
@@ -29,8 +34,19 @@ private:
         ar & movesPerTurn;
         ar & movesLeft;
         ar & weapons;
+        if (version >= 1) {
+            ar & botTargetPosition;
+            ar & botTargetMoves;
+        }
+        if (version >= 2)
+            ar & botTargetWeapon;
+        else
+            botTargetWeapon = currentWeapon;
     }
 
+    // points the copied references at the clones, and drops what copies never share
+    void relink(const Entity::clone_map_t &clones);
+
 protected:
     TankController();
 
@@ -38,15 +54,28 @@ public:
     static const int BOT_ATTEMPT_SPEED = 5;
     static const int BOT_MAX_ATTEMPT_TIME = 80;
     static constexpr int RANDOM_ATTEMPTS_BY_BOT_DIFFICULTY[] = {
-        5, 20, 80
+        5, 20, 80, 80
+    };
+    static constexpr int MOVES_BY_BOT_DIFFICULTY[] = {
+        5, 15, 50, 50
+    };
+    static constexpr bool LOOKAHEAD_BY_BOT_DIFFICULTY[] = {
+        false, false, false, true
     };
+    static const int START_WEAPONS = 6;
+    static const int MIN_WEAPONS = 2;
+
     static const int BOT_STEPS = 6;
     static const int BOT_TICKS_BETWEEN_STEPS = 4;
     std::vector<std::shared_ptr<BotAttempt>> botAttempts;
     std::shared_ptr<Tank> botTargetTank;
     Vector2 botTarget;
+    Vector2 botTargetPosition;
+    int botTargetMoves = 0;
     int botTargetAngle = -1;
     int botTargetPower = -1;
+    int botTargetWeapon = 0;
+    std::shared_future<BotPlanner::result_t> botPlan;
     int botStepsDone;
     int botLastStepTick;
     int botDifficulty;
@@ -59,14 +88,29 @@ public:
     int movesLeft = movesPerTurn;
 
     static std::shared_ptr<TankController> create();
+    std::shared_ptr<TankController> clone(const Entity::clone_map_t &clones);
+    // the same as clone(), but into a player that already exists
+    void copyFrom(const TankController &other, const Entity::clone_map_t &clones);
 
     std::vector<std::pair<std::shared_ptr<Weapon>, int>> weapons;
     void addWeapon(std::shared_ptr<Weapon> weapon, int amount);
-    void addRandomWeapon();
+    void addRandomWeapon(TankMatch *match);
     int getWeaponCount();
 
+    void chooseBotTarget(TankMatch *match);
+    static void planFiringGroup(TankMatch *match);
+    // works out a plan on threads threads of its own, applyAI() applies it once it is ready
+    void startBotPlan(TankMatch *match, int playerNumber, int maxMoves,
+        std::shared_ptr<const TankMatch::Land> land, int threads);
+    void applyPlan(TankMatch *match, const BotPlanner::result_t &result);
+    void clearBotAttempts(TankMatch *match);
+
+    // whether the bot is waiting on a plan that is still being worked out
+    bool isBotThinking() const;
     static bool applyAI(TankMatch *match, TankController &player);
 };
 
 }
 }
+
+BOOST_CLASS_VERSION(Hilltop::Game::TankController, 2)
@@ -4,13 +4,19 @@
 #include "Game/BulletRainWeapon.h"
 #include "Game/DirtRocketWeapon.h"
 #include "Game/GroundRocketWeapon.h"
+#include "Game/Hash.h"
 #include "Game/HealthDrop.h"
 #include "Game/MinigunWeapon.h"
 #include "Game/ParticleBombWeapon.h"
+#include "Game/Profiler.h"
+#include "Game/Replay.h"
 #include "Game/RocketWeapon.h"
+#include "Game/ShotPreview.h"
 #include "Game/TankController.h"
 #include "Game/TracerWeapon.h"
 #include "Game/WeaponDrop.h"
+#include <stdexcept>
+#include <typeinfo>
 
 
 namespace Hilltop {
@@ -19,76 +25,126 @@ namespace Game {
 static const Console::ConsoleColor LAND_COLORS[TankMatch::NUM_LAND_TYPES] =
     { Console::DARK_BLUE, Console::DARK_GREEN, Console::BROWN };
 
+// air hashes to nothing, so the empty land starts out with a hash of zero
+static uint64_t getCellKey(size_t cell, TankMatch::LandType type) {
+    return type == TankMatch::AIR ? 0 : mixHash(((uint64_t)cell << 2 | type) + 1);
+}
+
+std::vector<std::shared_ptr<Entity>> TankMatch::getSavedEntities() const {
+    std::vector<std::shared_ptr<Entity>> ret;
+    for (const std::shared_ptr<Entity> &entity : entities)
+        if (!entity->isTransient())
+            ret.push_back(entity);
+    return ret;
+}
+
+std::queue<std::pair<bool, std::shared_ptr<Entity>>> TankMatch::getSavedEntityChanges() const {
+    std::queue<std::pair<bool, std::shared_ptr<Entity>>> ret;
+    std::queue<std::pair<bool, std::shared_ptr<Entity>>> changes = entityChanges;
+    for (; !changes.empty(); changes.pop())
+        if (!changes.front().second->isTransient())
+            ret.push(changes.front());
+    return ret;
+}
+
 bool TankMatch::doEntityTick() {
+    // transient entities never count as a change, so when a turn ends doesn't depend on them and
+    // plays out the same in forks and loaded saves, which leave them out
     bool ret = false;
 
-    for (const std::shared_ptr<Entity> &p : entities) {
-        p->onTick(this);
+    {
+        HILLTOP_PROFILE_SCOPE(Profiler::ENTITY_ON_TICK, !headless);
+        for (const std::shared_ptr<Entity> &p : entities) {
+            p->onTick(this);
+        }
     }
 
-    while (!entityChanges.empty()) {
-        std::pair<bool, std::shared_ptr<Entity>> ev = entityChanges.front();
-        entityChanges.pop();
-
-        std::vector<std::shared_ptr<Entity>>::iterator it =
-            std::find(entities.begin(), entities.end(), ev.second);
-        bool exists = it != entities.end();
-
-        if (ev.first) {
-            if (!exists) {
-                entities.push_back(ev.second);
-                ret = true;
-            }
-        } else {
-            if (exists) {
-                entities.erase(it);
-                ret = true;
+    {
+        HILLTOP_PROFILE_SCOPE(Profiler::ENTITY_CHANGES, !headless);
+        while (!entityChanges.empty()) {
+            std::pair<bool, std::shared_ptr<Entity>> ev = entityChanges.front();
+            entityChanges.pop();
+
+            std::vector<std::shared_ptr<Entity>>::iterator it =
+                std::find(entities.begin(), entities.end(), ev.second);
+            bool exists = it != entities.end();
+
+            if (ev.first) {
+                if (!exists) {
+                    ev.second->previousPosition = ev.second->position;
+                    entities.push_back(ev.second);
+                    rehash(*ev.second);
+                    ret |= !ev.second->isTransient();
+                    if (Instrumentation::ENABLED)
+                        Instrumentation::countEntityAdded();
+                }
+            } else {
+                if (exists) {
+                    entities.erase(it);
+                    entityHash -= ev.second->hashKey;
+                    ev.second->hashKey = 0;
+                    ret |= !ev.second->isTransient();
+                    if (Instrumentation::ENABLED)
+                        Instrumentation::countEntityRemoved();
+                }
             }
         }
     }
 
-    for (const std::shared_ptr<Entity> &p : entities) {
-        if (p->entityAge <= 0)
-            continue;
+    {
+        HILLTOP_PROFILE_SCOPE(Profiler::ENTITY_PHYSICS, !headless);
+        const float timeStep = getTimeStep();
+        // the last thing a step does to each entity, after anything else could change it, so
+        // entityHash is up to date between steps
+        for (const std::shared_ptr<Entity> &p : entities) {
+            if (p->entityAge <= 0) {
+                rehash(*p);
+                continue;
+            }
 
-        for (int i = 0; i < p->physicsSpeed; i++) {
-            Vector2 oldPos = p->position;
-            Vector2 newPos = oldPos + p->direction;
-            std::pair<bool, Vector2> hit = checkForHit(oldPos, newPos, p->groundHog);
-            p->position = hit.second;
-            if (hit.first)
-                p->onHit(this);
+            for (int i = 0; i < p->physicsSpeed; i++) {
+                Vector2 oldPos = p->position;
+                Vector2 newPos = oldPos + p->direction * timeStep;
+                std::pair<bool, Vector2> hit = checkForHit(oldPos, newPos, p->groundHog);
+                p->position = hit.second;
+                if (hit.first)
+                    p->onHit(this);
 
-            if (oldPos.round() != p->position.round())
-                ret = true;
+                if (oldPos.round() != p->position.round() && !p->isTransient())
+                    ret = true;
 
-            p->direction = p->direction + gravity * p->gravityMult;
-        }
+                p->direction = p->direction + gravity * p->gravityMult * timeStep;
+            }
 
-        Vector2 pos = p->position.round();
-        if (pos.Y < 0 || pos.Y >= width || pos.X > height + 1) {
-            p->onExpire(this);
-            removeEntity(*p);
+            Vector2 pos = p->position.round();
+            if (pos.Y < 0 || pos.Y >= width || pos.X > height + 1) {
+                p->onExpire(this);
+                removeEntity(*p);
+            }
+            rehash(*p);
         }
     }
 
     return ret;
 }
 
-bool TankMatch::doLandPhysics() {
-    bool ret = false;
-    for (int i = height - 1; i > 0; i--) {
-        for (int j = 0; j < width; j++) {
-            LandType top = get(i - 1, j);
-            LandType bottom = get(i, j);
-            if (bottom == AIR && top != AIR) {
-                set(i, j, top);
-                set(i - 1, j, AIR);
-                ret = true;
-            }
-        }
+void TankMatch::rehash(Entity &entity) {
+    const uint64_t key = entity.isTransient() ? 0 : entity.getHash();
+    entityHash += key - entity.hashKey;
+    entity.hashKey = key;
+}
+
+void TankMatch::rehashEntities() {
+    entityHash = 0;
+    for (const std::shared_ptr<Entity> &entity : entities) {
+        entity->hashKey = 0;
+        rehash(*entity);
     }
-    return ret;
+}
+
+bool TankMatch::doLandPhysics() {
+    HILLTOP_PROFILE_SCOPE(Profiler::LAND_PHYSICS, !headless);
+    return land.doPhysics();
 }
 
 std::vector<std::shared_ptr<Weapon>> TankMatch::weapons;
@@ -163,7 +219,64 @@ void TankMatch::initalizeWeapons() {
             __debugbreak();
 }
 
-TankMatch::LandType TankMatch::get(int x, int y) {
+TankMatch::Land::Land(unsigned short width, unsigned short height)
+    : width(width), height(height), tilesWide((width + TILE_SIZE - 1) / TILE_SIZE), generation(1) {
+    // every tile starts out as the same empty one, which none of them owns
+    const int tilesHigh = (height + TILE_SIZE - 1) / TILE_SIZE;
+    tiles.assign(tilesWide * tilesHigh, std::make_shared<tile_t>());
+    tileGenerations.assign(tiles.size(), 0);
+}
+
+TankMatch::Land::Land(const Land &other)
+    : width(other.width), height(other.height), revision(other.revision), hash(other.hash),
+    tiles(other.tiles), tilesWide(other.tilesWide), settledRevision(other.settledRevision),
+    settled(other.settled), tileGenerations(other.tiles.size(), 0), generation(1) {
+    other.generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+TankMatch::Land &TankMatch::Land::operator=(const Land &other) {
+    if (this == &other)
+        return *this;
+
+    width = other.width;
+    height = other.height;
+    revision = other.revision;
+    hash = other.hash;
+    tiles = other.tiles;
+    tilesWide = other.tilesWide;
+    settledRevision = other.settledRevision;
+    settled = other.settled;
+    tileGenerations.assign(tiles.size(), 0);
+    generation.fetch_add(1, std::memory_order_relaxed);
+    other.generation.fetch_add(1, std::memory_order_relaxed);
+    return *this;
+}
+
+void TankMatch::Land::copyFrom(const Land &other) {
+    if (this == &other)
+        return;
+    if (width != other.width || height != other.height)
+        *this = Land(other.width, other.height);
+
+    revision = other.revision;
+    hash = other.hash;
+    settledRevision = other.settledRevision;
+    settled = other.settled;
+    for (size_t i = 0; i < tiles.size(); i++)
+        if (tiles[i] == other.tiles[i] || *tiles[i] != *other.tiles[i])
+            getWritableTile(i) = *other.tiles[i];
+}
+
+TankMatch::Land::tile_t &TankMatch::Land::getWritableTile(size_t index) {
+    const uint64_t current = generation.load(std::memory_order_relaxed);
+    if (tileGenerations[index] != current) {
+        tiles[index] = std::make_shared<tile_t>(*tiles[index]);
+        tileGenerations[index] = current;
+    }
+    return *tiles[index];
+}
+
+TankMatch::LandType TankMatch::Land::get(int x, int y) const {
     if (x < 0 || x >= height || y < 0 || y >= width) {
         if (x >= height)
             return TankMatch::DIRT;
@@ -171,20 +284,236 @@ TankMatch::LandType TankMatch::get(int x, int y) {
             return TankMatch::AIR;
     }
 
-    return map[x * width + y];
+    const tile_t &tile = *tiles[(x / TILE_SIZE) * tilesWide + y / TILE_SIZE];
+    return tile[(x % TILE_SIZE) * TILE_SIZE + y % TILE_SIZE];
 }
 
-void TankMatch::set(int x, int y, LandType type) {
+void TankMatch::Land::set(int x, int y, LandType type) {
     if (x < 0 || x >= height || y < 0 || y >= width)
         return;
 
-    map[x * width + y] = type;
+    const size_t t = (x / TILE_SIZE) * tilesWide + y / TILE_SIZE;
+    const int cell = (x % TILE_SIZE) * TILE_SIZE + y % TILE_SIZE;
+    const LandType old = (*tiles[t])[cell];
+    if (old == type)
+        return;
+
+    const size_t index = (size_t)x * width + y;
+    hash ^= getCellKey(index, old) ^ getCellKey(index, type);
+    getWritableTile(t)[cell] = type;
+    revision++;
+}
+
+bool TankMatch::Land::doPhysics() {
+    if (settled && settledRevision == revision)
+        return false;
+
+    bool ret = false;
+    for (int i = height - 1; i > 0; i--) {
+        const int bottomTiles = i / TILE_SIZE * tilesWide;
+        const int topTiles = (i - 1) / TILE_SIZE * tilesWide;
+        const int bottomRow = i % TILE_SIZE * TILE_SIZE;
+        const int topRow = (i - 1) % TILE_SIZE * TILE_SIZE;
+
+        // reads go straight through the tiles, only the rare cell that falls goes through set()
+        for (int t = 0; t < tilesWide; t++) {
+            const LandType *bottom = tiles[bottomTiles + t]->data() + bottomRow;
+            const LandType *top = tiles[topTiles + t]->data() + topRow;
+            const int columns = std::min<int>(TILE_SIZE, width - t * TILE_SIZE);
+            for (int j = 0; j < columns; j++) {
+                if (bottom[j] == AIR && top[j] != AIR) {
+                    const int y = t * TILE_SIZE + j;
+                    set(i, y, top[j]);
+                    set(i - 1, y, AIR);
+                    ret = true;
+
+                    // either tile may have been copied
+                    bottom = tiles[bottomTiles + t]->data() + bottomRow;
+                    top = tiles[topTiles + t]->data() + topRow;
+                }
+            }
+        }
+    }
+
+    settled = !ret;
+    settledRevision = revision;
+    return ret;
+}
+
+void TankMatch::Land::fill(const std::vector<int> &surface, LandType type) {
+    // tiles that end up all the same share one, the way a new land shares its empty tile
+    std::shared_ptr<tile_t> full;
+    const int tilesHigh = (height + TILE_SIZE - 1) / TILE_SIZE;
+    for (int t = 0; t < tilesHigh; t++) {
+        const int top = t * TILE_SIZE;
+        const int bottom = std::min<int>(top + TILE_SIZE, height);
+        for (int u = 0; u < tilesWide; u++) {
+            const int left = u * TILE_SIZE;
+            const int right = std::min<int>(left + TILE_SIZE, width);
+            bool covered = bottom - top == TILE_SIZE && right - left == TILE_SIZE;
+            bool changed = false;
+            const size_t index = t * tilesWide + u;
+            const tile_t &tile = *tiles[index];
+            for (int y = left; y < right; y++) {
+                if (surface[y] > top)
+                    covered = false;
+                for (int x = std::max(surface[y], top); x < bottom; x++) {
+                    const LandType old = tile[(x - top) * TILE_SIZE + y - left];
+                    if (old != type) {
+                        const size_t cell = (size_t)x * width + y;
+                        hash ^= getCellKey(cell, old) ^ getCellKey(cell, type);
+                        changed = true;
+                    }
+                }
+            }
+            if (!changed)
+                continue;
+
+            if (covered) {
+                if (!full) {
+                    full = std::make_shared<tile_t>();
+                    full->fill(type);
+                }
+                // shared by every covered tile, so none of them owns it
+                tiles[index] = full;
+                tileGenerations[index] = 0;
+                continue;
+            }
+
+            tile_t &writable = getWritableTile(index);
+            for (int y = left; y < right; y++)
+                for (int x = std::max(surface[y], top); x < bottom; x++)
+                    writable[(x - top) * TILE_SIZE + y - left] = type;
+        }
+    }
+    revision++;
+}
+
+std::pair<bool, Vector2> TankMatch::Land::checkForHit(const Vector2 from, const Vector2 to,
+    bool groundHog) const {
+    std::pair<bool, Vector2> ret = std::make_pair(false, to);
+    foreachPixel(from, to, [this, &ret, groundHog](Vector2 p)->bool {
+        LandType land = get(p.X, p.Y);
+        if ((land == AIR) == groundHog) {
+            ret = std::make_pair(true, p);
+            return true;
+        }
+        return false;
+    });
+    return ret;
+}
+
+std::vector<unsigned char> TankMatch::Land::encode() const {
+    const size_t size = (size_t)width * height;
+    std::vector<unsigned char> ret;
+    for (size_t i = 0; i < size;) {
+        const LandType type = get(i / width, i % width);
+        size_t length = 1;
+        while (i + length < size && get((i + length) / width, (i + length) % width) == type)
+            length++;
+        i += length;
+
+        ret.push_back(type);
+        for (; length >= 0x80; length >>= 7)
+            ret.push_back((unsigned char)(length | 0x80));
+        ret.push_back((unsigned char)length);
+    }
+    return ret;
+}
+
+void TankMatch::Land::decode(const std::vector<unsigned char> &data) {
+    size_t cell = 0;
+    for (size_t i = 0; i < data.size();) {
+        const LandType type = (LandType)data[i++];
+        size_t length = 0;
+        for (int shift = 0; i < data.size(); shift += 7) {
+            const unsigned char byte = data[i++];
+            length |= (size_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                break;
+        }
+
+        if (type >= NUM_LAND_TYPES || length > (size_t)width * height - cell)
+            throw std::runtime_error("Corrupted land data");
+        for (; length > 0; length--, cell++)
+            set(cell / width, cell % width, type);
+    }
+
+    if (cell != (size_t)width * height)
+        throw std::runtime_error("Corrupted land data");
+    revision++;
+}
+
+TankMatch::LandType TankMatch::get(int x, int y) {
+    return land.get(x, y);
+}
+
+void TankMatch::set(int x, int y, LandType type) {
+    land.set(x, y, type);
 }
 
 TankMatch::TankMatch() : TankMatch(DEFAULT_MATCH_WIDTH, DEFAULT_MATCH_HEIGHT) {}
 
 TankMatch::TankMatch(unsigned short width, unsigned short height)
-    : width(width), height(height), map(width * height), canvas(width, height) {}
+    : width(width), height(height), land(width, height), canvas(width, height) {}
+
+TankMatch::TankMatch(unsigned short width, unsigned short height, bool headless)
+    : width(width), height(height), land(width, height), canvas(headless ? 0 : width,
+    headless ? 0 : height), headless(headless) {}
+
+std::shared_ptr<TankMatch> TankMatch::fork(bool headless) {
+    headless |= this->headless;
+    std::shared_ptr<TankMatch> ret = headless ?
+        std::make_shared<TankMatch>(width, height, true) : std::make_shared<TankMatch>(width, height);
+    ret->land = land;
+    std::copy(std::begin(recentUpdateResult), std::end(recentUpdateResult),
+        std::begin(ret->recentUpdateResult));
+    ret->currentPlayer = currentPlayer;
+    ret->gravity = gravity;
+    ret->updateMattered = updateMattered;
+    ret->tickNumber = tickNumber;
+    ret->isAiming = isAiming;
+    ret->gameOver = gameOver;
+    ret->shownGameOver = shownGameOver;
+    ret->lowestAir = lowestAir;
+    ret->highestLand = highestLand;
+    ret->firingMode = firingMode;
+    ret->ticksPerSecond = ticksPerSecond;
+    ret->rng = rng;
+
+    Entity::clone_map_t clones;
+    std::function<void(const std::shared_ptr<Entity> &)> cloneEntity =
+        [&clones](const std::shared_ptr<Entity> &entity) {
+        if (entity && clones.find(entity.get()) == clones.end())
+            clones[entity.get()] = entity->clone();
+    };
+
+    for (const std::shared_ptr<Entity> &entity : getSavedEntities())
+        cloneEntity(entity);
+    std::queue<std::pair<bool, std::shared_ptr<Entity>>> changes = getSavedEntityChanges();
+    for (; !changes.empty(); changes.pop())
+        cloneEntity(changes.front().second);
+    for (const std::shared_ptr<TankController> &player : players) {
+        cloneEntity(player->tank);
+        for (const std::shared_ptr<Entity> &wheel : player->tank->wheels)
+            cloneEntity(wheel);
+        cloneEntity(player->botTargetTank);
+    }
+
+    for (const std::pair<const Entity *const, std::shared_ptr<Entity>> &clone : clones)
+        clone.second->relink(clones);
+
+    for (const std::shared_ptr<Entity> &entity : getSavedEntities())
+        ret->entities.push_back(Entity::relinked(clones, entity));
+    for (changes = getSavedEntityChanges(); !changes.empty(); changes.pop())
+        ret->entityChanges.push(std::make_pair(changes.front().first,
+            Entity::relinked(clones, changes.front().second)));
+    for (const std::shared_ptr<TankController> &player : players)
+        ret->players.push_back(player->clone(clones));
+    ret->rehashEntities();
+
+    return ret;
+}
 
 void TankMatch::addEntity(Entity &entity) {
     entityChanges.push(make_pair(true, entity.shared_from_this()));
@@ -195,11 +524,10 @@ void TankMatch::removeEntity(Entity &entity) {
 }
 
 void TankMatch::buildMap(std::function<float(float)> generator) {
-    for (int i = 0; i < width; i++) {
-        int val = height - generator((float)i / width) * height;
-        for (int j = height - 1; j >= val; j--)
-            set(j, i, GRASS);
-    }
+    std::vector<int> surface(width);
+    for (int i = 0; i < width; i++)
+        surface[i] = std::max(0, (int)(height - generator((float)i / width) * height));
+    land.fill(surface, GRASS);
 }
 
 void TankMatch::arrangeTanks() {
@@ -221,7 +549,7 @@ void TankMatch::arrangeTanks() {
     std::sort(teams.begin(), teams.end(), [](team_t x, team_t y)->bool {
         return x.second > y.second;
     });
-    if (scale(rand(), 0, RAND_MAX, 0, 1) >= 0.5f)
+    if (scale(random(), 0, RANDOM_MAX, 0, 1) >= 0.5f)
         std::reverse(teams.begin(), teams.end());
 
     int leftBound = 10;
@@ -250,20 +578,11 @@ void TankMatch::arrangeTanks() {
 
 std::pair<bool, Vector2> TankMatch::checkForHit(const Vector2 from, const Vector2 to,
     bool groundHog) {
-    std::pair<bool, Vector2> ret = std::make_pair(false, to);
-    foreachPixel(from, to, [this, &ret, groundHog](Vector2 p)->bool {
-        LandType land = get(p.X, p.Y);
-        if ((land == AIR) == groundHog) {
-            ret = std::make_pair(true, p);
-            return true;
-        }
-        return false;
-    });
-    return ret;
+    return land.checkForHit(from, to, groundHog);
 }
 
 void TankMatch::doAirdrop() {
-    int val = rand() % 3;
+    int val = random() % 3;
     std::shared_ptr<Drop> drop;
     switch (val) {
     case 0:
@@ -276,11 +595,46 @@ void TankMatch::doAirdrop() {
         drop = WeaponDrop::create();
         break;
     }
-    drop->position = { -10, (float)(rand() % width) };
+    drop->position = { -10, (float)(random() % width) };
     addEntity(*drop);
 }
 
-void TankMatch::draw(Console::BufferedConsole &console) {
+int TankMatch::random() {
+    // the low bits of a linear congruential generator repeat quickly, so take them from the top
+    return (int)((rng() >> 15) & RANDOM_MAX);
+}
+
+int TankMatch::getStepsPerTick() const {
+    return (DEFAULT_TICKS_PER_SECOND + ticksPerSecond - 1) / ticksPerSecond;
+}
+
+float TankMatch::getTimeStep() const {
+    return (float)DEFAULT_TICKS_PER_SECOND / (float)(ticksPerSecond * getStepsPerTick());
+}
+
+uint64_t TankMatch::toDefaultTicks(uint64_t steps) const {
+    // whole numbers only, so every rate agrees on which step something happens on
+    return steps * DEFAULT_TICKS_PER_SECOND / (ticksPerSecond * getStepsPerTick());
+}
+
+int TankMatch::countDue(uint64_t step, int every) const {
+    if (step == 0)
+        return 0;
+    return (int)(toDefaultTicks(step) / every - toDefaultTicks(step - 1) / every);
+}
+
+void TankMatch::draw(Console::BufferedConsole &console, float alpha) {
+    HILLTOP_PROFILE_SCOPE(Profiler::MATCH_DRAW);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    drawPositions.clear();
+    if (alpha < 1.0f) {
+        for (const std::shared_ptr<Entity> &p : entities) {
+            drawPositions.push_back(p->position);
+            p->position = p->previousPosition + (p->position - p->previousPosition) * alpha;
+        }
+    }
+
     lowestAir = 0;
     highestLand = height - 1;
 
@@ -305,7 +659,13 @@ void TankMatch::draw(Console::BufferedConsole &console) {
     }
 
     if (isAiming && players[currentPlayer]->isHuman) {
-        if (tickNumber % (AIM_RETICLE_TIME * 2) < AIM_RETICLE_TIME)
+        if (showShotPreview) {
+            if (!shotPreview)
+                shotPreview = std::make_shared<ShotPreview>();
+            shotPreview->draw(this, *players[currentPlayer], canvas);
+        }
+        if (toDefaultTicks(tickNumber * getStepsPerTick()) % (AIM_RETICLE_TIME * 2) <
+            AIM_RETICLE_TIME)
             players[currentPlayer]->tank->drawReticle(this, canvas);
     }
 
@@ -314,18 +674,159 @@ void TankMatch::draw(Console::BufferedConsole &console) {
     for (const std::shared_ptr<Entity> &p : entities) {
         p->onDirectDraw(this, console);
     }
+
+    for (size_t i = 0; i < drawPositions.size(); i++)
+        entities[i]->position = drawPositions[i];
+
+    if (!headless)
+        lastDrawTime = std::chrono::steady_clock::now() - start;
+}
+
+bool TankMatch::movedLastTick() const {
+    for (const std::shared_ptr<Entity> &p : entities)
+        if (p->previousPosition.round() != p->position.round())
+            return true;
+    return false;
+}
+
+void TankMatch::copyForDrawing(TankMatch &view) const {
+    view.land.copyFrom(land);
+    view.currentPlayer = currentPlayer;
+    view.gravity = gravity;
+    view.showShotPreview = showShotPreview;
+    view.headless = true;
+    view.tickNumber = tickNumber;
+    view.isAiming = isAiming;
+    view.gameOver = gameOver;
+    view.firingMode = firingMode;
+    view.ticksPerSecond = ticksPerSecond;
+
+    // entities that were already copied last time are copied over their old clones, so only new
+    // ones allocate
+    Entity::clone_map_t &clones = view.drawClones;
+    view.drawCopied.clear();
+    auto copyEntity = [&clones, &view](const std::shared_ptr<Entity> &entity) {
+        if (!entity)
+            return;
+
+        std::shared_ptr<Entity> &clone = clones[entity.get()];
+        if (!clone || typeid(*clone) != typeid(*entity) || !clone->copyFrom(*entity))
+            clone = entity->clone();
+        view.drawCopied.push_back(entity.get());
+    };
+
+    for (const std::shared_ptr<Entity> &entity : entities)
+        copyEntity(entity);
+    for (const std::shared_ptr<TankController> &player : players) {
+        copyEntity(player->tank);
+        for (const std::shared_ptr<Entity> &wheel : player->tank->wheels)
+            copyEntity(wheel);
+        copyEntity(player->botTargetTank);
+    }
+
+    // drops the clones of entities that are gone, both lists are in address order
+    std::sort(view.drawCopied.begin(), view.drawCopied.end());
+    std::vector<const Entity *>::const_iterator copied = view.drawCopied.begin();
+    for (Entity::clone_map_t::iterator it = clones.begin(); it != clones.end();) {
+        while (copied != view.drawCopied.end() && *copied < it->first)
+            copied++;
+        if (copied == view.drawCopied.end() || *copied != it->first)
+            it = clones.erase(it);
+        else
+            it++;
+    }
+
+    for (const std::pair<const Entity *const, std::shared_ptr<Entity>> &clone : clones)
+        clone.second->relink(clones);
+
+    view.entities.clear();
+    for (const std::shared_ptr<Entity> &entity : entities)
+        view.entities.push_back(Entity::relinked(clones, entity));
+    if (view.players.size() != players.size()) {
+        view.players.clear();
+        for (const std::shared_ptr<TankController> &player : players)
+            view.players.push_back(player->clone(clones));
+    } else {
+        for (size_t i = 0; i < players.size(); i++)
+            view.players[i]->copyFrom(*players[i], clones);
+    }
+}
+
+void TankMatch::setDrawTime(std::chrono::steady_clock::duration time) {
+    lastDrawTime = time;
 }
 
 void TankMatch::tick() {
+    HILLTOP_PROFILE_SCOPE(Profiler::TICK, !headless);
+    const Instrumentation::counters_t before = Instrumentation::ENABLED ?
+        Instrumentation::getThreadTotals() : Instrumentation::counters_t();
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
     tickNumber++;
     updateMattered = false;
 
-    if (tickNumber % LAND_PHYSICS_EVERY_TICKS == 0)
-        updateMattered |= doLandPhysics();
+    for (const std::shared_ptr<Entity> &p : entities)
+        p->previousPosition = p->position;
+
+    const int steps = getStepsPerTick();
+    for (int i = 1; i <= steps; i++)
+        updateMattered |= step((tickNumber - 1) * steps + i);
+
+    if (recording)
+        recording->onTick(*this);
+
+    if (!headless)
+        updateDegradation(std::chrono::steady_clock::now() - start);
+
+    if (Instrumentation::ENABLED) {
+        lastTick.counters = Instrumentation::getThreadTotals() - before;
+        // counted after the totals are taken, the first entity of a type allocates a map node
+        for (std::pair<const std::type_index, int> &type : lastTick.liveEntities)
+            type.second = 0;
+        for (const std::shared_ptr<Entity> &p : entities)
+            lastTick.liveEntities[typeid(*p)]++;
+    }
+}
+
+bool TankMatch::step(uint64_t stepNumber) {
+    bool ret = false;
+
+    if (countDue(stepNumber, LAND_PHYSICS_EVERY_TICKS))
+        ret |= doLandPhysics();
+
+    ret |= doEntityTick();
 
-    updateMattered |= doEntityTick();
+    // the results are kept per tick at the default rate, so the turn waits as long at any rate
+    const uint64_t from = toDefaultTicks(stepNumber - 1);
+    const uint64_t to = toDefaultTicks(stepNumber);
+    if (from == to)
+        recentUpdateResult[to % RECENT_UPDATE_COUNT] |= ret;
+    else
+        recentUpdateResult[to % RECENT_UPDATE_COUNT] = ret;
 
-    recentUpdateResult[tickNumber % RECENT_UPDATE_COUNT] = updateMattered;
+    return ret;
+}
+
+void TankMatch::updateDegradation(std::chrono::steady_clock::duration tickTime) {
+    const std::chrono::steady_clock::duration budget = std::chrono::duration_cast<
+        std::chrono::steady_clock::duration>(std::chrono::seconds(1)) * tickTimeBudgetPercent /
+        (100 * ticksPerSecond);
+    const std::chrono::steady_clock::duration time = tickTime + lastDrawTime;
+    const int count = (int)entities.size();
+
+    if (count > entityBudget || time > budget) {
+        degradation = std::min(degradation + 1, (int)MAX_DEGRADATION);
+        ticksUnderBudget = 0;
+    } else if (degradation > DEGRADE_NONE && count * 4 <= entityBudget * 3 &&
+        time * 4 <= budget * 3) {
+        // a second at the match's rate
+        if (++ticksUnderBudget >= ticksPerSecond) {
+            degradation--;
+            ticksUnderBudget = 0;
+        }
+    } else {
+        ticksUnderBudget = 0;
+    }
 }
 
 bool TankMatch::recentUpdatesMattered() {
@@ -335,6 +836,39 @@ bool TankMatch::recentUpdatesMattered() {
     return false;
 }
 
+uint64_t TankMatch::getHash() const {
+    uint64_t ret = land.hash;
+    addHash(ret, entityHash);
+    addHash(ret, tickNumber);
+    addHash(ret, (uint64_t)currentPlayer);
+    addHash(ret, (uint64_t)(isAiming | gameOver << 1));
+
+    // the number it would give next, the engine's whole state and all of it that it passes on
+    std::minstd_rand next = rng;
+    addHash(ret, (uint64_t)next());
+
+    // tanks are entities, this is only what the players have on top of them
+    for (const std::shared_ptr<TankController> &player : players) {
+        addHash(ret, (uint64_t)player->movesLeft);
+        addHash(ret, (uint64_t)player->currentWeapon);
+        addHash(ret, (uint64_t)player->weapons.size());
+        addHash(ret, (uint64_t)player->getWeaponCount());
+    }
+
+    return ret;
+}
+
+bool TankMatch::settle(int maxTicks, std::chrono::steady_clock::time_point deadline) {
+    for (uint64_t i = 0; toDefaultTicks(i * getStepsPerTick()) < (uint64_t)maxTicks; i++) {
+        if (std::chrono::steady_clock::now() >= deadline)
+            return false;
+        tick();
+        if (!recentUpdatesMattered())
+            return true;
+    }
+    return false;
+}
+
 void TankMatch::fire(int playerNumber) {
     std::shared_ptr<TankController> player = players[playerNumber];
     std::pair<std::shared_ptr<Weapon>, int> &weapon = player->weapons[player->currentWeapon];
@@ -344,30 +878,120 @@ void TankMatch::fire(int playerNumber) {
 }
 
 void TankMatch::fire() {
+    if (!isLastToAim(currentPlayer))
+        return;
+
     if (firingMode == FIRE_SOLO) {
         fire(currentPlayer);
     } else if (firingMode == FIRE_AS_TEAM) {
-        bool found = false;
-        for (int i = currentPlayer + 1; i < players.size(); i++) {
-            if (players[i]->team == players[currentPlayer]->team) {
-                found = true;
-                break;
-            }
+        for (int i = 0; i < players.size(); i++)
+            if (players[i]->team == players[currentPlayer]->team && players[i]->tank->alive)
+                fire(i);
+    } else if (firingMode == FIRE_EVERYTHING) {
+        for (int i = 0; i < players.size(); i++)
+            if (players[i]->tank->alive)
+                fire(i);
+    }
+
+    // a plan made for someone who didn't get to aim is stale once the land changes
+    for (const std::shared_ptr<TankController> &player : players)
+        player->botPlan = std::shared_future<BotPlanner::result_t>();
+}
+
+bool TankMatch::canMove(int direction) {
+    const TankController &player = *players[currentPlayer];
+    return (direction == -1 || direction == 1) && player.movesLeft > 0 &&
+        player.tank->canMove(this, direction);
+}
+
+void TankMatch::doCommand(const command_t &command) {
+    TankController &player = *players[currentPlayer];
+    switch (command.type) {
+    case COMMAND_MOVE:
+        // thrown before recording, like an invalid type
+        if (!canMove(command.value))
+            throw std::runtime_error("Invalid move");
+        player.movesLeft--;
+        player.tank->doMove(this, command.value);
+        break;
+    case COMMAND_ANGLE:
+        player.tank->angle = command.value;
+        break;
+    case COMMAND_POWER:
+        player.tank->power = command.value;
+        break;
+    case COMMAND_WEAPON:
+        player.currentWeapon = command.value;
+        break;
+    case COMMAND_FIRE:
+        fire();
+        isAiming = false;
+        break;
+    case COMMAND_END_TURN:
+        endTurn();
+        break;
+    case NUM_COMMAND_TYPES:
+        // thrown before recording, so a bad command never makes it into a replay
+        throw std::runtime_error("Invalid command type");
+    }
+
+    if (recording)
+        recording->record(*this, command);
+}
+
+void TankMatch::endTurn() {
+    for (const std::shared_ptr<TankController> &player : players) {
+        if (player->weapons[player->currentWeapon].second <= 0) {
+            player->weapons.erase(player->weapons.begin() + player->currentWeapon);
+            player->currentWeapon = 0;
         }
+        if (player->getWeaponCount() <= TankController::MIN_WEAPONS) {
+            while (player->getWeaponCount() < TankController::START_WEAPONS)
+                player->addRandomWeapon(this);
+        }
+    }
+
+    int nextPlayer = getNextPlayer();
+    if (nextPlayer >= 0) {
+        currentPlayer = nextPlayer;
+        players[currentPlayer]->movesLeft = players[currentPlayer]->movesPerTurn;
+        isAiming = true;
+        if (random() % AIRDROP_EVERY_TURNS == 0)
+            doAirdrop();
+    } else {
+        gameOver = true;
+    }
+}
 
-        if (!found)
-            for (int i = 0; i < players.size(); i++)
-                if (players[i]->team == players[currentPlayer]->team && players[i]->tank->alive)
-                    fire(i);
+bool TankMatch::isLastToAim(int playerNumber) {
+    if (firingMode == FIRE_AS_TEAM) {
+        for (int i = playerNumber + 1; i < players.size(); i++)
+            if (players[i]->team == players[playerNumber]->team)
+                return false;
     } else if (firingMode == FIRE_EVERYTHING) {
-        if (currentPlayer == players.size() - 1)
-            for (int i = 0; i < players.size(); i++)
-                if (players[i]->tank->alive)
-                    fire(i);
+        return playerNumber == players.size() - 1;
     }
+
+    return true;
+}
+
+std::vector<int> TankMatch::getFiringGroup() {
+    std::vector<int> group;
+    int player = currentPlayer;
+    while (player >= 0 && std::find(group.begin(), group.end(), player) == group.end()) {
+        group.push_back(player);
+        if (isLastToAim(player))
+            break;
+        player = getNextPlayer(player);
+    }
+    return group;
 }
 
 int TankMatch::getNextPlayer() {
+    return getNextPlayer(currentPlayer);
+}
+
+int TankMatch::getNextPlayer(int currentPlayer) {
     int currentTeam = players[currentPlayer]->team;
     int minTeam = currentTeam;
     int maxTeam = currentTeam;
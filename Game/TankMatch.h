@@ -1,14 +1,24 @@
 #pragma once
 
 #include "Game/Entity.h"
+#include "Game/Instrumentation.h"
 #include "Game/Weapon.h"
 #include <boost/serialization/split_member.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/version.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <queue>
+#include <random>
+#include <sstream>
 
 
 namespace Hilltop {
 namespace Game {
 
+class Replay;
+class ShotPreview;
 class TankController;
 
 class TankMatch {
@@ -20,11 +30,66 @@ public:
         NUM_LAND_TYPES,
     };
 
+    class Land {
+    public:
+        static const int TILE_SIZE = 16;
+        typedef std::array<LandType, TILE_SIZE * TILE_SIZE> tile_t;
+
+        unsigned short width, height;
+        // bumped whenever a cell changes, so anything derived from the land knows to redo itself
+        unsigned int revision = 0;
+        // a Zobrist hash of every cell that isn't air, kept up to date by set()
+        uint64_t hash = 0;
+
+        Land(unsigned short width, unsigned short height);
+        // shares every tile with other, and neither of them writes to a shared tile afterwards
+        Land(const Land &other);
+        Land &operator=(const Land &other);
+        // makes this land the same as other without sharing tiles with it, so other keeps writing
+        // to its tiles in place. Only copies the tiles that differ, and only allocates for tiles
+        // this land doesn't have a copy of its own of yet.
+        void copyFrom(const Land &other);
+
+        LandType get(int x, int y) const;
+        void set(int x, int y, LandType type);
+        std::pair<bool, Vector2> checkForHit(const Vector2 from, const Vector2 to,
+            bool groundHog = false) const;
+        // drops everything with air under it by one cell, returns whether anything fell
+        bool doPhysics();
+        // sets every cell from surface[column] down to the bottom of its column
+        void fill(const std::vector<int> &surface, LandType type);
+
+        // runs of the same cell as a type byte and a varint length
+        std::vector<unsigned char> encode() const;
+        void decode(const std::vector<unsigned char> &data);
+
+    private:
+        // copies of the land share tiles until one of them changes something in a tile, so
+        // copying the land only copies pointers
+        std::vector<std::shared_ptr<tile_t>> tiles;
+        unsigned short tilesWide;
+        // the revision doPhysics() last found nothing to drop at, nothing can fall until it changes
+        unsigned int settledRevision = 0;
+        bool settled = false;
+        // a tile is only written in place while its entry here matches generation, which is only
+        // the case for tiles this land copied since it was last copied itself. Every other tile
+        // may be seen by another land, on another thread, and gets copied before it changes.
+        std::vector<uint64_t> tileGenerations;
+        // bumped every time the land is copied, even from a const reference, and by every thread
+        // copying it at once. Copying still can't overlap with changing the land.
+        mutable std::atomic<uint64_t> generation;
+
+        tile_t &getWritableTile(size_t index);
+    };
+
     friend class boost::serialization::access;
     template<class Archive>
     void save(Archive &ar, const unsigned int version) const {
-        ar & entities;
-        ar & entityChanges;
+        std::vector<std::shared_ptr<Entity>> savedEntities = getSavedEntities();
+        std::queue<std::pair<bool, std::shared_ptr<Entity>>> savedEntityChanges =
+            getSavedEntityChanges();
+        ar & savedEntities;
+        ar & savedEntityChanges;
         ar & recentUpdateResult;
         ar & players;
         ar & currentPlayer;
@@ -34,23 +99,15 @@ public:
         ar & gameOver;
         ar & firingMode;
 
-        if (map.size() > 0) {
-            LandType lastType = map[0];
-            size_t spanLength = 1;
-            for (int i = 1; i < map.size(); i++) {
-                LandType type = map[i];
-                if (type != lastType) {
-                    ar & lastType;
-                    ar & spanLength;
-                    lastType = type;
-                    spanLength = 1;
-                } else {
-                    spanLength++;
-                }
-            }
-            ar & lastType;
-            ar & spanLength;
-        }
+        std::vector<unsigned char> landData = land.encode();
+        ar & landData;
+
+        std::ostringstream rngState;
+        rngState << rng;
+        std::string savedRngState = rngState.str();
+        ar & savedRngState;
+
+        ar & ticksPerSecond;
     }
     template<class Archive>
     void load(Archive &ar, const unsigned int version) {
@@ -65,21 +122,38 @@ public:
         ar & gameOver;
         ar & firingMode;
 
+        if (version >= 1) {
+            std::vector<unsigned char> landData;
+            ar & landData;
+            land.decode(landData);
+
+            if (version >= 2) {
+                std::string savedRngState;
+                ar & savedRngState;
+                std::istringstream rngState(savedRngState);
+                rngState >> rng;
+
+                if (version >= 3)
+                    ar & ticksPerSecond;
+            }
+            rehashEntities();
+            return;
+        }
+
         LandType type;
         size_t spanLength = 0;
-        for (int i = 0; i < map.size(); i++) {
+        for (int i = 0; i < land.width * land.height; i++) {
             if (spanLength == 0) {
                 ar & type;
                 ar & spanLength;
             }
-            map[i] = type;
+            land.set(i / land.width, i % land.width, type);
             spanLength--;
         }
+        rehashEntities();
     }
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 
-    std::vector<LandType> map;
-
     std::vector<std::shared_ptr<Entity>> entities;
     std::queue<std::pair<bool, std::shared_ptr<Entity>>> entityChanges;
 
@@ -89,8 +163,32 @@ public:
     static const int AIM_RETICLE_TIME = 6;
     static const int LAND_PHYSICS_EVERY_TICKS = 3;
 
+    std::vector<std::shared_ptr<Entity>> getSavedEntities() const;
+    std::queue<std::pair<bool, std::shared_ptr<Entity>>> getSavedEntityChanges() const;
+
+    // kept between calls so drawing and copyForDrawing() don't allocate once they've warmed up:
+    // where entities really are while they're drawn in between ticks, and for a view, the clone
+    // of every entity it copied last time, along with the entities it just copied
+    std::vector<Vector2> drawPositions;
+    Entity::clone_map_t drawClones;
+    std::vector<const Entity *> drawCopied;
+
+    // how long the last draw took, only kept for matches that aren't headless, see setDrawTime()
+    std::chrono::steady_clock::duration lastDrawTime = std::chrono::steady_clock::duration::zero();
+    int ticksUnderBudget = 0;
+
+    // the sum of the hashKey of every entity, see getHash()
+    uint64_t entityHash = 0;
+
     bool doEntityTick();
     bool doLandPhysics();
+    // brings the entity's share of entityHash up to date, nothing for transient ones
+    void rehash(Entity &entity);
+    // works entityHash out from scratch, for a match that was just forked or loaded
+    void rehashEntities();
+    // everything a tick does but recording it, returns whether anything changed
+    bool step(uint64_t stepNumber);
+    void updateDegradation(std::chrono::steady_clock::duration tickTime);
 
 public:
     enum FiringMode {
@@ -103,10 +201,55 @@ public:
 
     static const int DEFAULT_MATCH_WIDTH = 180;
     static const int DEFAULT_MATCH_HEIGHT = 90;
+    // the new game screen only starts matches of the default size, and the game window is only
+    // laid out for matches up to it
+    static const int MIN_MATCH_WIDTH = 32;
+    static const int MIN_MATCH_HEIGHT = 16;
+    static const int MAX_MATCH_WIDTH = DEFAULT_MATCH_WIDTH;
+    static const int MAX_MATCH_HEIGHT = DEFAULT_MATCH_HEIGHT;
+
+    static const int DEFAULT_TICKS_PER_SECOND = 20;
+    static const int MIN_TICKS_PER_SECOND = 5;
+    static const int MAX_TICKS_PER_SECOND = 60;
 
     static const int AIRDROP_EVERY_TURNS = 12;
 
+    static const int DEFAULT_ENTITY_BUDGET = 400;
+    static const int DEFAULT_TICK_TIME_BUDGET_PERCENT = 50;
+
+    // how far trails are cut back to keep a match within its budget, each level adding to the one
+    // before it
+    enum Degradation {
+        DEGRADE_NONE,
+        // one trail entity for every tick of a rocket's flight instead of one for every pixel
+        DEGRADE_MERGE_TRAILS,
+        // trails last half as long, and a quarter as long at the next level
+        DEGRADE_SHORTEN_TRAILS,
+        // trails are only left every other tick at the default rate
+        DEGRADE_THIN_TRAILS,
+        MAX_DEGRADATION = DEGRADE_THIN_TRAILS,
+    };
+
+    static const int RANDOM_MAX = 0x7FFF;
+
+    enum CommandType : unsigned char {
+        COMMAND_MOVE,
+        COMMAND_ANGLE,
+        COMMAND_POWER,
+        COMMAND_WEAPON,
+        COMMAND_FIRE,
+        COMMAND_END_TURN,
+        NUM_COMMAND_TYPES,
+    };
+
+    // something the current player does, humans and bots alike, so that it can be recorded
+    struct command_t {
+        CommandType type;
+        int value;
+    };
+
     const unsigned short width, height;
+    Land land;
     Console::DoublePixelBufferedConsole canvas;
 
     std::vector<std::shared_ptr<TankController>> players;
@@ -114,6 +257,10 @@ public:
 
     Vector2 gravity = { 0.15f, 0.0f };
     bool updateMattered = false;
+    bool showShotPreview = false;
+    std::shared_ptr<ShotPreview> shotPreview;
+    // set on matches that are only simulated, such as the forks bots search through
+    bool headless = false;
     uint64_t tickNumber = 0;
     bool isAiming = true;
     bool gameOver = false;
@@ -122,12 +269,39 @@ public:
     unsigned short highestLand;
 
     FiringMode firingMode = FIRE_AS_TEAM;
+    // how many times tick() runs for every second of the match. Speeds, gravity and everything
+    // counted in ticks are written for DEFAULT_TICKS_PER_SECOND and go through getTimeStep(),
+    // toDefaultTicks() and countDue(), so the match plays out alike at any rate
+    int ticksPerSecond = DEFAULT_TICKS_PER_SECOND;
+    // once a match has more entities than this, or a tick and a draw take longer than this share of
+    // the tick period, degradation goes up a level every tick. It comes back down a level at a
+    // time after a second well within both. Only matches that aren't headless are ever degraded,
+    // and only trails, which are transient and never keep a turn going, so only what is drawn
+    // changes.
+    int entityBudget = DEFAULT_ENTITY_BUDGET;
+    int tickTimeBudgetPercent = DEFAULT_TICK_TIME_BUDGET_PERCENT;
+    int degradation = DEGRADE_NONE;
+
+    // everything random in the simulation comes from here, so the same seed and the same
+    // commands always play out the same match
+    std::minstd_rand rng;
+    // gets every command applied to the match when set, it isn't saved or forked
+    std::shared_ptr<Replay> recording;
+    // only filled in by builds with HILLTOP_INSTRUMENT
+    Instrumentation::tick_t lastTick;
 
     static std::vector<std::shared_ptr<Weapon>> weapons;
     static void initalizeWeapons();
 
     TankMatch();
     TankMatch(unsigned short width, unsigned short height);
+    // a headless match with no canvas, it must never be drawn
+    TankMatch(unsigned short width, unsigned short height, bool headless);
+
+    // an independent copy of the match without transient entities, sharing nothing but the weapon
+    // definitions and the land tiles neither of them has changed since. Forks of headless
+    // matches, and forks asked to be headless, are left without a canvas and can't be drawn.
+    std::shared_ptr<TankMatch> fork(bool headless = false);
 
     LandType get(int x, int y);
     void set(int x, int y, LandType type);
@@ -139,15 +313,59 @@ public:
     void arrangeTanks();
     std::pair<bool, Vector2> checkForHit(const Vector2 from, const Vector2 to, bool groundHog = false);
     void doAirdrop();
-
-    void draw(Console::BufferedConsole &console);
+    // between 0 and RANDOM_MAX
+    int random();
+
+    // a tick is one step at or above the default rate, and as many whole default ticks as it
+    // takes below it, so nothing ever moves further in one step than it does at the default rate
+    int getStepsPerTick() const;
+    // the length of a step in ticks at the default rate, what anything moving is moved by
+    float getTimeStep() const;
+    // how many ticks at the default rate the given number of steps make up. Entity ages count
+    // steps, and are the same as ticks at or above the default rate.
+    uint64_t toDefaultTicks(uint64_t steps) const;
+    // how many times something done every `every` ticks at the default rate is due on the given
+    // step, counted from 1. Only ever 0 or 1.
+    int countDue(uint64_t step, int every) const;
+
+    // alpha picks a point between where entities were before the last tick, at 0, and where they
+    // are now, at 1, so the match can be drawn more often than it ticks
+    void draw(Console::BufferedConsole &console, float alpha = 1.0f);
+    // whether drawing with an alpha below 1 would show anything different
+    bool movedLastTick() const;
+    // makes view, a match of the same size that is only ever drawn, look like this one, including
+    // the transient entities fork() leaves out. The view keeps its own canvas and shot preview, so
+    // it can be drawn on another thread while this match ticks on.
+    void copyForDrawing(TankMatch &view) const;
+    // how long drawing such a view took, which counts towards the tick time budget the same as
+    // drawing the match itself
+    void setDrawTime(std::chrono::steady_clock::duration time);
 
     void tick();
     bool recentUpdatesMattered();
+    // of everything that decides how the match plays out from here on: the land, the players, the
+    // random numbers and the entities that aren't transient, the same for a match and for a fork
+    // or a load of it between ticks. The land and the entities are kept hashed as they change, so
+    // it only walks the players.
+    uint64_t getHash() const;
+    // ticks until things stop moving, like the game loop does before handing over the turn, for
+    // at most maxTicks ticks at the default rate and not past the deadline
+    bool settle(int maxTicks, std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::time_point::max());
     void fire(int playerNumber);
     void fire();
+    // whether the current player has a move left and room to take a step that way, -1 or 1
+    bool canMove(int direction);
+    // throws on commands that can never be applied, such as a move canMove() refuses
+    void doCommand(const command_t &command);
+    // cleans up after the shots of a turn, hands it to the next player and maybe drops a crate
+    void endTurn();
+    bool isLastToAim(int playerNumber);
+    // the current player and everyone who still has to aim before their shots go off together
+    std::vector<int> getFiringGroup();
 
     int getNextPlayer();
+    int getNextPlayer(int currentPlayer);
 };
 
 template<class Archive>
@@ -166,3 +384,5 @@ inline void load_construct_data(Archive &ar, TankMatch *t, const unsigned int) {
 
 }
 }
+
+BOOST_CLASS_VERSION(Hilltop::Game::TankMatch, 3)
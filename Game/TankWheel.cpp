@@ -1,4 +1,5 @@
 #include "Game/TankWheel.h"
+#include "Game/TankMatch.h"
 
 
 namespace Hilltop {
@@ -12,6 +13,15 @@ std::shared_ptr<TankWheel> TankWheel::create() {
     return std::shared_ptr<TankWheel>(new TankWheel());
 }
 
+std::shared_ptr<Entity> TankWheel::clone() {
+    return std::shared_ptr<TankWheel>(new TankWheel(*this));
+}
+
+bool TankWheel::copyFrom(const Entity &other) {
+    *this = static_cast<const TankWheel &>(other);
+    return true;
+}
+
 void TankWheel::onDraw(TankMatch *match, Console::DoublePixelBufferedConsole &console) {
     Entity::onDraw(match, console);
 
@@ -19,7 +29,7 @@ void TankWheel::onDraw(TankMatch *match, Console::DoublePixelBufferedConsole &co
         return;
 
     Vector2 p = position.round();
-    if (entityAge % 2 == 0)
+    if (match->toDefaultTicks(entityAge) % 2 == 0)
         console.set(p.X, p.Y, Console::RED);
 }
 
@@ -22,6 +22,8 @@ public:
 
     static std::shared_ptr<TankWheel> create();
 
+    virtual std::shared_ptr<Entity> clone() override;
+    virtual bool copyFrom(const Entity &other) override;
     virtual void onDraw(TankMatch *match, Console::DoublePixelBufferedConsole &console) override;
 };
 
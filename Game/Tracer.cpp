@@ -12,6 +12,15 @@ std::shared_ptr<Tracer> Tracer::create() {
     return std::shared_ptr<Tracer>(new Tracer());
 }
 
+std::shared_ptr<Entity> Tracer::clone() {
+    return std::shared_ptr<Tracer>(new Tracer(*this));
+}
+
+bool Tracer::copyFrom(const Entity &other) {
+    *this = static_cast<const Tracer &>(other);
+    return true;
+}
+
 void Tracer::onTick(TankMatch *match) {
     Entity::onTick(match);
 
@@ -36,7 +45,7 @@ void Tracer::onDirectDraw(TankMatch *match, Console::BufferedConsole &console) {
 
 void Tracer::onHit(TankMatch *match) {
     if (!hasHit) {
-        maxEntityAge = entityAge + DURATION;
+        maxEntityAge = (int)match->toDefaultTicks(entityAge) + DURATION;
         gravityMult = 0.0f;
     }
 
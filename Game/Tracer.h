@@ -25,6 +25,8 @@ public:
 
     static std::shared_ptr<Tracer> create();
 
+    virtual std::shared_ptr<Entity> clone() override;
+    virtual bool copyFrom(const Entity &other) override;
     virtual void onTick(TankMatch *match) override;
     virtual void onDraw(TankMatch *match, Console::DoublePixelBufferedConsole &console) override;
     virtual void onDirectDraw(TankMatch *match, Console::BufferedConsole &console);
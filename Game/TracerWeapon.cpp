@@ -23,5 +23,15 @@ void TracerWeapon::fire(TankMatch &match, int playerNumber) {
     }
 }
 
+Weapon::profile_t TracerWeapon::getProfile() {
+    // tracers only show where shots would go
+    profile_t profile;
+    profile.kind = profile_t::NONE;
+    profile.numRockets = 0;
+    profile.explosionSize = 0;
+    profile.damagesTanks = false;
+    return profile;
+}
+
 }
 }
@@ -21,6 +21,7 @@ public:
     TracerWeapon();
 
     virtual void fire(TankMatch &match, int playerNumber) override;
+    virtual profile_t getProfile() override;
 };
 
 }
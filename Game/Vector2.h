@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <boost/serialization/access.hpp>
+#include <cmath>
 #include <functional>
 
 #pragma warning(disable: 4244)
@@ -73,7 +74,22 @@ public:
 
 float distance(const Vector2 from, const Vector2 to);
 
-void foreachPixel(const Vector2 from, const Vector2 to, std::function<bool(Vector2)> handler);
+template<class Handler>
+void foreachPixel(const Vector2 from, const Vector2 to, Handler handler) {
+    Vector2 start = from.round();
+    Vector2 end = to.round();
+    int steps = std::max(1, (int)std::ceil(std::max(std::abs(start.X - end.X), std::abs(start.Y - end.Y))));
+    Vector2 lastPixel = start;
+    for (int i = 0; i <= steps; i++) {
+        float pos = scale(i, 0, steps, 0, 1);
+        Vector2 p = (start + (end - start) * pos).round();
+        if (i == 0 || p != lastPixel) {
+            lastPixel = p;
+            if (handler(p))
+                break;
+        }
+    }
+}
 
 }
 }
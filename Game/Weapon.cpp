@@ -8,5 +8,9 @@ const std::string Weapon::INVALID_NAME = "<invalid name>";
 
 void Weapon::fire(TankMatch &match, int playerNumber) {}
 
+Weapon::profile_t Weapon::getProfile() {
+    return profile_t();
+}
+
 }
 }
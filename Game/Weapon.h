@@ -20,11 +20,31 @@ private:
     }
 
 public:
+    // what fire() launches, so bots can simulate a weapon without spawning entities
+    struct profile_t {
+        enum Kind {
+            NONE,
+            ROCKET,
+            BOUNCY,
+            GROUND,
+            PARTICLE_BOMB,
+            BULLET_RAIN,
+            MINIGUN,
+        };
+
+        Kind kind = NONE;
+        int numRockets = 1;
+        int explosionSize = 5;
+        float explosionDamage = 1.0f;
+        bool damagesTanks = true;
+    };
+
     static const std::string INVALID_NAME;
 
     std::string name = INVALID_NAME;
 
     virtual void fire(TankMatch &match, int playerNumber);
+    virtual profile_t getProfile();
 };
 
 }
@@ -14,11 +14,20 @@ std::shared_ptr<WeaponDrop> WeaponDrop::create() {
     return std::shared_ptr<WeaponDrop>(new WeaponDrop());
 }
 
+std::shared_ptr<Entity> WeaponDrop::clone() {
+    return std::shared_ptr<WeaponDrop>(new WeaponDrop(*this));
+}
+
+bool WeaponDrop::copyFrom(const Entity &other) {
+    *this = static_cast<const WeaponDrop &>(other);
+    return true;
+}
+
 void WeaponDrop::handleTank(TankMatch *match, Tank &tank) {
     for (const std::shared_ptr<TankController> &player : match->players) {
         if (player->tank.get() == &tank) {
             for (int i = 0; i < WEAPONS; i++)
-                player->addRandomWeapon();
+                player->addRandomWeapon(match);
             break;
         }
     }
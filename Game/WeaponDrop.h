@@ -22,6 +22,8 @@ public:
 
     static std::shared_ptr<WeaponDrop> create();
 
+    virtual std::shared_ptr<Entity> clone() override;
+    virtual bool copyFrom(const Entity &other) override;
     virtual void handleTank(TankMatch *match, Tank &tank) override;
 };
 
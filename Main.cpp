@@ -1,120 +1,53 @@
 ﻿#include "Console/BufferedNativeConsole.h"
+#include "Console/FrameRing.h"
+#include "Console/MemoryConsole.h"
 #include "Console/SnapshotConsole.h"
+#include "Console/TripleBuffer.h"
 #include "Console/Windows/WindowsConsole.h"
+#include "Game/Benchmark.h"
+#include "Game/FramePacer.h"
+#include "Game/LatencyHistogram.h"
+#include "Game/MatchFile.h"
+#include "Game/MatchSetup.h"
+#include "Game/Profiler.h"
+#include "Game/Replay.h"
 #include "Game/TankController.h"
 #include "UI/Button.h"
 #include "UI/ElementCollection.h"
 #include "UI/Form.h"
 #include "UI/ProgressBar.h"
 #include "UI/TextBox.h"
-#include <boost/archive/iterators/base64_from_binary.hpp>
-#include <boost/archive/iterators/binary_from_base64.hpp>
-#include <boost/archive/iterators/transform_width.hpp>
-#include <boost/archive/text_oarchive.hpp>
-#include <boost/archive/text_iarchive.hpp>
-#include <boost/serialization/access.hpp>
-#include <boost/serialization/base_object.hpp>
-#include <boost/serialization/deque.hpp>
-#include <boost/serialization/export.hpp>
-#include <boost/serialization/queue.hpp>
-#include <boost/serialization/set.hpp>
-#include <boost/serialization/shared_ptr.hpp>
-#include <boost/serialization/utility.hpp>
-#include <boost/serialization/vector.hpp>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 #include <deque>
+#include <exception>
 #include <fstream>
 #include <functional>
+#include <future>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <typeinfo>
 #include <Windows.h>
 
 #define VK_A 0x41
 
-#include "Game/Entity.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::Entity)
-
-#include "Game/BotAttempt.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::BotAttempt)
-
-#include "Game/SimpleRocket.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::SimpleRocket)
-
-#include "Game/SimpleTrailedRocket.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::SimpleTrailedRocket)
-
-#include "Game/GroundTrailedRocket.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::GroundTrailedRocket)
-
-#include "Game/BouncyTrailedRocket.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::BouncyTrailedRocket)
-
-#include "Game/RocketTrail.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::RocketTrail)
-
-#include "Game/Explosion.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::Explosion)
-
-#include "Game/Tracer.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::Tracer)
-
-#include "Game/TankWheel.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::TankWheel)
-
-#include "Game/Tank.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::Tank)
-
-#include "Game/Drop.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::Drop)
-
-#include "Game/HealthDrop.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::HealthDrop)
-
-#include "Game/ArmorDrop.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::ArmorDrop)
-
-#include "Game/WeaponDrop.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::WeaponDrop)
-
-#include "Game/ParticleBomb.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::ParticleBomb)
-
-#include "Game/BulletRainCloud.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::BulletRainCloud)
-
-#include "Game/Minigun.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::Minigun)
-
-#include "Game/Weapon.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::Weapon)
-
-#include "Game/RocketWeapon.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::RocketWeapon)
-
-#include "Game/DirtRocketWeapon.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::DirtRocketWeapon)
-
-#include "Game/GroundRocketWeapon.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::GroundRocketWeapon)
-
-#include "Game/BouncyRocketWeapon.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::BouncyRocketWeapon)
-
-#include "Game/ParticleBombWeapon.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::ParticleBombWeapon)
-
-#include "Game/BulletRainWeapon.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::BulletRainWeapon)
-
-#include "Game/MinigunWeapon.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::MinigunWeapon)
-
-#include "Game/TracerWeapon.h"
-BOOST_CLASS_EXPORT(Hilltop::Game::TracerWeapon)
-
-
+// the rate of menus and input, matches tick at their own TankMatch::ticksPerSecond
 #define GAME_TICKS_PER_SEC 20
-#define GAME_TICK_MS (1000 / GAME_TICKS_PER_SEC)
+// ticks a loop that fell behind may run back to back, the rest are skipped
+#define MAX_CATCH_UP_TICKS 10
+// how often a match is shown, drawn between its ticks when it ticks less often
+#define DISPLAY_FRAMES_PER_SEC 60
+// where every build logs how long the ticks and frames of every match took, and profiling and
+// instrumented builds also what was going on during every tick that took longer than its period
+#define LATENCY_LOG_FILENAME "latency.log"
 
 using namespace Hilltop::Console;
 using namespace Hilltop::Game;
@@ -123,11 +56,9 @@ using namespace Hilltop::UI;
 const unsigned short MENU_WIDTH = 100;
 const unsigned short MENU_HEIGHT = 25;
 
-std::shared_ptr<BufferedConsole> console;
+const bool LOG_SLOW_TICKS = Profiler::ENABLED || Instrumentation::ENABLED;
 
-
-const int START_WEAPONS = 6;
-const int MIN_WEAPONS = 2;
+std::shared_ptr<BufferedConsole> console;
 
 
 std::shared_ptr<ElementCollection> bottomArea;
@@ -150,9 +81,41 @@ std::shared_ptr<TextBox> powerText;
 
 
 std::shared_ptr<TankMatch> match;
+// set while watching a replay, which then drives the match instead of the players
+std::shared_ptr<ReplayPlayer> replayPlayer;
 std::shared_ptr<Form> gameForm;
+// held by the simulation thread while it ticks, and by menus and anything else touching the match
+// while it runs. The game UI belongs to the input thread, which draws it over the frames the
+// simulation hands over and never waits on the lock otherwise.
+std::mutex matchMutex;
 bool exitMatch = false;
+// what the controls ask of the match, applied by the simulation thread before its next tick
+std::mutex inputMutex;
+std::vector<std::function<void()>> pendingInput;
+// runs the match as fast as it goes whenever nobody has to act, see canFastForward()
+std::atomic<bool> fastForward(false);
+// the frames shown recently, and which of them show the last shot
+std::shared_ptr<FrameRing> frameRing;
+bool shotInProgress = false;
+bool hasLastShot = false;
+uint64_t lastShotFirstFrame = 0;
+uint64_t lastShotLastFrame = 0;
 bool reenterMatch = false;
+// how long the ticks and the frames of the current match took, frames from copying the frame to
+// committing it
+LatencyHistogram tickLatency;
+LatencyHistogram frameLatency;
+// given to every match that is shown, see parseOptions()
+int entityBudget = TankMatch::DEFAULT_ENTITY_BUDGET;
+int tickTimeBudgetPercent = TankMatch::DEFAULT_TICK_TIME_BUDGET_PERCENT;
+// what logSlowTick() found, kept by the simulation thread until it lets go of matchMutex
+std::string slowTickLog;
+
+std::future<void> pendingSave;
+bool pendingSaveIsAutosave = false;
+std::string saveStatus;
+ULONGLONG saveStatusTime = 0;
+int turnsSinceAutosave = 0;
 
 
 std::shared_ptr<TextBox> playerText[4];
@@ -162,7 +125,9 @@ std::shared_ptr<TextBox> playerTank[4];
 std::shared_ptr<TextBox> newGameStartText;
 
 
-const wchar_t fileDialogFilter[] = L"Hilltop Map (*.htm)\0*.htm\0All Files\0*.*\0\0";
+const wchar_t fileDialogFilter[] =
+    L"Hilltop Save (*.hts)\0*.hts\0Hilltop Save Page (*.htm)\0*.htm\0Hilltop Replay (*.htr)\0*.htr\0"
+    L"All Files\0*.*\0\0";
 wchar_t fileDialogBuffer[MAX_PATH] = {};
 std::wstring chosenFilename;
 
@@ -172,7 +137,7 @@ static OPENFILENAME buildOpenFileName() {
     open.lpstrFile = fileDialogBuffer;
     open.nMaxFile = sizeof(fileDialogBuffer) / sizeof(*fileDialogBuffer);
     open.lpstrFilter = fileDialogFilter;
-    open.lpstrDefExt = L"htm";
+    open.lpstrDefExt = L"hts";
     return open;
 }
 
@@ -217,16 +182,17 @@ static void preventResizeWindow() {
     SetWindowLong(window, GWL_STYLE, style & ~WS_SIZEBOX);
 }
 
-static void tickLoop(std::function<void()> tick, std::function<bool()> loop) {
-    ULONGLONG lastTime = GetTickCount64();
+static FramePacer::clock_t::duration getTickPeriod(int ticksPerSecond) {
+    return std::chrono::duration_cast<FramePacer::clock_t::duration>(std::chrono::seconds(1)) /
+        ticksPerSecond;
+}
 
-    while (true) {
-        int ticks = std::min<int>((int)((GetTickCount64() - lastTime) / GAME_TICK_MS), 10);
-        if (ticks < 1) {
-            Sleep(1);
-            continue;
-        }
+static void tickLoop(std::function<void()> tick, std::function<bool()> loop,
+    int ticksPerSecond = GAME_TICKS_PER_SEC) {
+    FramePacer pacer(getTickPeriod(ticksPerSecond), MAX_CATCH_UP_TICKS);
 
+    while (true) {
+        int ticks = pacer.wait();
         while (ticks--) {
             if (tick)
                 tick();
@@ -234,8 +200,6 @@ static void tickLoop(std::function<void()> tick, std::function<bool()> loop) {
 
         if (!loop())
             break;
-
-        lastTime = GetTickCount64();
     }
 }
 
@@ -318,38 +282,75 @@ void messageBox(std::string text, std::string title = "") {
     });
 }
 
-static void saveGame() {
+static std::wstring getExtension(const std::wstring &filename) {
+    const size_t ext = filename.find_last_of(L'.');
+    return ext == std::wstring::npos ? L"" : filename.substr(ext);
+}
+
+static void copyToClipboard(const std::string &text) {
+    if (!OpenClipboard(GetConsoleWindow()))
+        throw std::runtime_error("Could not open the clipboard");
+    EmptyClipboard();
+    HGLOBAL memory = GlobalAlloc(GMEM_MOVEABLE, text.size() + 1);
+    if (memory) {
+        std::memcpy(GlobalLock(memory), text.c_str(), text.size() + 1);
+        GlobalUnlock(memory);
+        if (!SetClipboardData(CF_TEXT, memory))
+            GlobalFree(memory);
+    }
+    CloseClipboard();
+}
+
+static std::string readClipboard() {
+    if (!OpenClipboard(GetConsoleWindow()))
+        throw std::runtime_error("Could not open the clipboard");
+    std::string ret;
+    HANDLE data = GetClipboardData(CF_TEXT);
+    if (data) {
+        const char *text = (const char *)GlobalLock(data);
+        if (text)
+            ret = text;
+        GlobalUnlock(data);
+    }
+    CloseClipboard();
+    return ret;
+}
+
+static void writeSaveFile(const std::wstring &filename, std::shared_ptr<TankMatch> match,
+    std::shared_ptr<Replay> replay) {
     static const std::string HTML_BEGIN = "<html><head><title>Hilltop Save File</title><style>body{text-align:center;font-family:Verdana,sans-serif;font-size:18pt}div{margin:20px;display:inline-block}span{font-size:0;display:block;margin:0;padding:0}b,i{display:inline-block;width:10px;height:10px}i{background-color:white}a{font-size:11pt;position:relative;top:-4pt;color:blue}pre{color:#ccc;white-space:normal;word-wrap:break-word;max-width:600px;font-size:7pt;margin-left:auto;margin-right:auto;text-align:justify}</style></head><body onload='document.getElementsByTagName(\"pre\")[0].innerHTML=atob(document.childNodes[1].textContent.trim())'><br>";
     static const std::string TANK_COMMON = "<span><i></i><b></b><b></b><b></b><b></b><b></b><i></i></span><span><b></b><b></b><b></b><b></b><b></b><b></b><b></b></span>";
     static const std::string TANK_LEFT = "<span><b></b><i></i><i></i><i></i><i></i><i></i><i></i></span><span><i></i><b></b><i></i><i></i><i></i><i></i><i></i></span><span><i></i><i></i><b></b><i></i><i></i><i></i><i></i></span>" + TANK_COMMON;
     static const std::string TANK_RIGHT = "<span><i></i><i></i><i></i><i></i><i></i><i></i><b></b></span><span><i></i><i></i><i></i><i></i><i></i><b></b><i></i></span><span><i></i><i></i><i></i><i></i><b></b><i></i><i></i></span>" + TANK_COMMON;
     static const std::string HTML_END = "<br><br>This is a save file for Hilltop.<br>Load it to continue your match.<br><br>Hilltop is a tank artillery game.<br>Download Hilltop at:<br><a href='https://github.com/Bogdacutu/Hilltop'>https://github.com/Bogdacutu/Hilltop</a><br><br><br><pre></pre></body></html>";
 
-    using namespace boost::archive::iterators;
-    typedef base64_from_binary<transform_width<std::string::iterator, 6, 8>> base64_t;
-
-    if (!askSaveFile())
+    const std::wstring extension = getExtension(filename);
+    if (extension == L".htr") {
+        if (!replay)
+            throw std::runtime_error("Only new matches are recorded, there is no replay to save");
+        std::ofstream fout(filename, std::ios::binary);
+        replay->write(fout);
+        if (!fout)
+            throw std::runtime_error("Could not write the replay file");
         return;
-    std::ofstream fout(chosenFilename);
-    chosenFilename.clear();
-
-    std::ostringstream ss;
-    boost::archive::text_oarchive archive(ss);
-    archive << match;
+    }
 
-    fout << "<!DOCTYPE html><!-- ";
-    {
-        std::string data = ss.str();
-        std::copy(base64_t(data.begin()), base64_t(data.end()), std::ostream_iterator<char>(fout));
-        fout << std::string((3 - data.size() % 3) % 3, '=');
-        ss.clear();
+    // anything not named like a web page gets the plain binary save
+    if (extension != L".htm" && extension != L".html") {
+        std::ofstream fout(filename, std::ios::binary);
+        MatchFile::write(fout, match);
+        if (!fout)
+            throw std::runtime_error("Could not write the save file");
+        return;
     }
-    fout << " -->";
+
+    std::ofstream fout(filename);
+    MatchFile::writeHtmlHeader(fout, match);
     
     std::vector<int> players;
     for (int i = 0; i < match->players.size(); i++)
         players.push_back(i);
-    std::sort(players.begin(), players.end(), [](int x, int y)->bool {
+    std::sort(players.begin(), players.end(), [&match](int x, int y)->bool {
         return match->players[x]->tank->position.Y < match->players[y]->tank->position.Y;
     });
 
@@ -369,27 +370,74 @@ static void saveGame() {
         fout << "</div>";
     }
     fout << HTML_END << std::endl;
+    if (!fout)
+        throw std::runtime_error("Could not write the save file");
+}
+
+static void finishSave(bool wait) {
+    if (!pendingSave.valid())
+        return;
+    if (!wait && pendingSave.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    try {
+        pendingSave.get();
+        saveStatus = pendingSaveIsAutosave ? "Autosaved" : "Game saved";
+        saveStatusTime = GetTickCount64();
+    } catch (std::exception &e) {
+        messageBox(e.what(), "Error while saving game");
+    }
+}
+
+// writes a copy of the match as it is now on another thread, so the game keeps running meanwhile
+static void startSave(const std::wstring &filename, bool autosave) {
+    finishSave(true);
+
+    std::shared_ptr<TankMatch> snapshot = match->fork(true);
+    std::shared_ptr<Replay> replay;
+    if (match->recording)
+        replay = std::make_shared<Replay>(*match->recording);
+    pendingSaveIsAutosave = autosave;
+    pendingSave = std::async(std::launch::async, [filename, snapshot, replay]() {
+        writeSaveFile(filename, snapshot, replay);
+    });
+}
+
+static void saveGame() {
+    if (!askSaveFile())
+        return;
+    std::wstring filename = chosenFilename;
+    chosenFilename.clear();
+
+    startSave(filename, false);
+}
+
+static void autosaveGame() {
+    static const int AUTOSAVE_EVERY_TURNS = 4;
+    static const wchar_t AUTOSAVE_FILENAME[] = L"autosave.hts";
+
+    // never held up behind a save that is still being written
+    if (++turnsSinceAutosave < AUTOSAVE_EVERY_TURNS || pendingSave.valid())
+        return;
+    turnsSinceAutosave = 0;
+    startSave(AUTOSAVE_FILENAME, true);
 }
 
 static bool loadGame() {
-    using namespace boost::archive::iterators;
-    typedef transform_width<binary_from_base64<std::string::iterator>, 8, 6> binary_t;
-    
     if (!askLoadFile())
         return false;
-    std::ifstream fin(chosenFilename);
+    std::ifstream fin(chosenFilename, std::ios::binary);
+    const bool isReplay = getExtension(chosenFilename) == L".htr";
     chosenFilename.clear();
 
-    fin.ignore(16, ' ');
-    fin.ignore(16, ' ');
-    std::string str;
-    fin >> str;
-
     try {
-        std::string decoded(binary_t(str.begin()), binary_t(str.end()));
-        std::istringstream ss(decoded);
-        boost::archive::text_iarchive archive(ss);
-        archive >> match;
+        if (isReplay) {
+            replayPlayer = std::make_shared<ReplayPlayer>(Replay::read(fin));
+            match = replayPlayer->match;
+        } else {
+            match = MatchFile::load(fin);
+            replayPlayer.reset();
+        }
     } catch (std::exception &e) {
         messageBox(e.what(), "Error while loading saved game");
         return false;
@@ -398,6 +446,35 @@ static bool loadGame() {
     return true;
 }
 
+static void queueInput(std::function<void()> input) {
+    std::lock_guard<std::mutex> lock(inputMutex);
+    pendingInput.push_back(input);
+}
+
+static void discardInput() {
+    std::lock_guard<std::mutex> lock(inputMutex);
+    pendingInput.clear();
+}
+
+// input is only ever meant for a human aiming, so whatever is left over once a shot is on its way
+// is dropped
+static void applyInput() {
+    std::vector<std::function<void()>> input;
+    {
+        std::lock_guard<std::mutex> lock(inputMutex);
+        if (pendingInput.empty())
+            return;
+        input.swap(pendingInput);
+    }
+
+    for (const std::function<void()> &apply : input) {
+        if (replayPlayer || match->gameOver || !match->isAiming ||
+            !match->players[match->currentPlayer]->isHuman)
+            break;
+        apply();
+    }
+}
+
 enum PauseScreenArea {
     PAUSED_RESUME_OPTION,
     PAUSED_LOAD_GAME_OPTION,
@@ -511,6 +588,7 @@ static void pauseScreen() {
         w = match->width;
         h = match->height;
         if (loadGame()) {
+            discardInput();
             if (match->width != w || match->height != h) {
                 exitMatch = true;
                 reenterMatch = true;
@@ -751,12 +829,17 @@ static bool weaponAreaAction(Form::event_args_t e) {
         return true;
     }
 
-    std::shared_ptr<TankController> player = match->players[match->currentPlayer];
-    player->currentWeapon = player->currentWeapon + delta;
-    if (player->currentWeapon < 0)
-        player->currentWeapon += (int)player->weapons.size();
-    else
-        player->currentWeapon %= (int)player->weapons.size();
+    if (delta != 0) {
+        queueInput([delta]() {
+            std::shared_ptr<TankController> player = match->players[match->currentPlayer];
+            int weapon = player->currentWeapon + delta;
+            if (weapon < 0)
+                weapon += (int)player->weapons.size();
+            else
+                weapon %= (int)player->weapons.size();
+            match->doCommand({ TankMatch::COMMAND_WEAPON, weapon });
+        });
+    }
 
     return delta != 0;
 }
@@ -802,13 +885,13 @@ static bool shadowPixel(BufferedConsole &console, unsigned short x, unsigned sho
     }
 }
 
-static void drawWeaponList() {
-    std::shared_ptr<TankController> player = match->players[match->currentPlayer];
+static void drawWeaponList(BufferedConsole &console, const TankMatch &shown) {
+    std::shared_ptr<TankController> player = shown.players[shown.currentPlayer];
     int height = (int)player->weapons.size();
     unsigned short x = 0;
     unsigned short y = 0;
     Form::findBounds(weaponArea, bottomArea, &x, &y);
-    std::shared_ptr<BufferedConsoleRegion> region = BufferedConsoleRegion::create(*console,
+    std::shared_ptr<BufferedConsoleRegion> region = BufferedConsoleRegion::create(console,
         weaponArea->width + 2, height + 2, x - height - 2, y - 1);
     region->enforceBounds = false;
     region->clear(BLACK);
@@ -841,12 +924,12 @@ static void drawWeaponList() {
     }
 }
 
-static void weaponAreaDraw() {
-    std::shared_ptr<TankController> player = match->players[match->currentPlayer];
+static void weaponAreaDraw(BufferedConsole &console, const TankMatch &shown) {
+    std::shared_ptr<TankController> player = shown.players[shown.currentPlayer];
     unsigned short x = 0;
     unsigned short y = 0;
     Form::findBounds(weaponArea, bottomArea, &x, &y);
-    std::shared_ptr<BufferedConsole> region = BufferedConsoleRegion::create(*console,
+    std::shared_ptr<BufferedConsole> region = BufferedConsoleRegion::create(console,
         weaponArea->width, 1, x + 1, y);
     drawWeaponEntry(*region, *player->weapons[player->currentWeapon].first,
         player->weapons[player->currentWeapon].second, true);
@@ -870,18 +953,19 @@ static bool moveAreaAction(Form::event_args_t e) {
         return true;
     }
 
-    std::shared_ptr<TankController> player = match->players[match->currentPlayer];
-    if (delta != 0 && player->movesLeft) {
-        player->movesLeft--;
-        player->tank->doMove(match.get(), delta);
+    if (delta != 0) {
+        queueInput([delta]() {
+            if (match->canMove(delta))
+                match->doCommand({ TankMatch::COMMAND_MOVE, delta });
+        });
     }
 
     return delta != 0;
 }
 
-static void moveAreaUpdate() {
+static void moveAreaUpdate(const TankMatch &shown) {
     std::ostringstream text;
-    text << "Moves left: " << match->players[match->currentPlayer]->movesLeft;
+    text << "Moves left: " << shown.players[shown.currentPlayer]->movesLeft;
     moveText->text = text.str();
 }
 
@@ -903,24 +987,28 @@ static bool angleAreaAction(Form::event_args_t e) {
         return true;
     }
 
-    int angle = match->players[match->currentPlayer]->tank->angle;
-    angle = (angle + delta) % 360;
-    if (angle < 0)
-        angle += 360;
-    match->players[match->currentPlayer]->tank->angle = angle;
+    if (delta != 0) {
+        queueInput([delta]() {
+            int angle = match->players[match->currentPlayer]->tank->angle;
+            angle = (angle + delta) % 360;
+            if (angle < 0)
+                angle += 360;
+            match->doCommand({ TankMatch::COMMAND_ANGLE, angle });
+        });
+    }
 
     return delta != 0;
 }
 
-static void angleAreaUpdate() {
-    int angle = match->players[match->currentPlayer]->tank->angle;
+static void angleAreaUpdate(const TankMatch &shown) {
+    int angle = shown.players[shown.currentPlayer]->tank->angle;
     std::ostringstream text;
     text << "Angle: " << angle;
     angleText->text = text.str();
     angleProgressTop->value = (float)std::min(180, angle) / 180.0f;
     angleProgressBottom->value = (float)std::max(0, angle - 180) / 179.0f;
 
-    ConsoleColor color = match->players[match->currentPlayer]->tank->color;
+    ConsoleColor color = shown.players[shown.currentPlayer]->tank->color;
     angleProgressTop->color = color;
     angleProgressBottom->color = color;
 }
@@ -945,52 +1033,153 @@ static bool powerAreaAction(Form::event_args_t e) {
         return true;
     }
 
-    int power = match->players[match->currentPlayer]->tank->power;
-    power = std::min(std::max(0, power + delta), 100);
-    match->players[match->currentPlayer]->tank->power = power;
+    if (delta != 0) {
+        queueInput([delta]() {
+            int power = match->players[match->currentPlayer]->tank->power;
+            power = std::min(std::max(0, power + delta), 100);
+            match->doCommand({ TankMatch::COMMAND_POWER, power });
+        });
+    }
 
     return delta != 0;
 }
 
-static void powerAreaUpdate() {
-    int power = match->players[match->currentPlayer]->tank->power;
+static void powerAreaUpdate(const TankMatch &shown) {
+    int power = shown.players[shown.currentPlayer]->tank->power;
     std::ostringstream text;
     text << "Power: " << power << "%";
     powerText->text = text.str();
     powerBar->value = (float)power / 100.0f;
 
-    ConsoleColor color = match->players[match->currentPlayer]->tank->color;
+    ConsoleColor color = shown.players[shown.currentPlayer]->tank->color;
     powerBar->color = color;
 }
 
 static bool fireButtonAction(Form::event_args_t e) {
-    match->fire();
-    match->isAiming = false;
-    match->tick();
+    queueInput([]() {
+        match->doCommand({ TankMatch::COMMAND_FIRE, 0 });
+        match->tick();
+    });
     e.form->currentPos = FIRE_BUTTON_TOP;
     e.form->isFocused = false;
     return true;
 }
 
-static void fireButtonUpdate() {
-    ConsoleColor color = match->players[match->currentPlayer]->tank->color;
+static void fireButtonUpdate(const TankMatch &shown) {
+    ConsoleColor color = shown.players[shown.currentPlayer]->tank->color;
     fireButton->backgroundColor = color;
     fireButton->color = is_bright_color(color) ? BLACK : WHITE;
 }
 
-static void gameFormUpdate() {
-    moveAreaUpdate();
-    fireButtonUpdate();
-    angleAreaUpdate();
-    powerAreaUpdate();
+static void gameFormUpdate(const TankMatch &shown) {
+    moveAreaUpdate(shown);
+    fireButtonUpdate(shown);
+    angleAreaUpdate(shown);
+    powerAreaUpdate(shown);
+}
+
+static void seekReplay(uint64_t tick) {
+    const bool showShotPreview = match->showShotPreview;
+    replayPlayer->seek(tick);
+    match = replayPlayer->match;
+    match->showShotPreview = showShotPreview;
+}
+
+static void instantReplayScreen() {
+    static const float SPEEDS[] = { 0.25f, 0.5f, 1.0f, 2.0f, 4.0f };
+    static const int NUM_SPEEDS = sizeof(SPEEDS) / sizeof(*SPEEDS);
+
+    std::shared_ptr<BufferedConsoleRegion> topRegion = BufferedConsoleRegion::create(*console,
+        console->width, 1, 0, 0);
+    std::shared_ptr<BufferedConsoleRegion> mainRegion = BufferedConsoleRegion::create(*console,
+        match->width, match->height / 2, 1, 2);
+    std::shared_ptr<Form> form = std::make_shared<Form>(1);
+
+    // frames are recorded one per tick at most, so playing one per tick is the normal speed
+    const uint64_t lastFrame = lastShotLastFrame;
+    float position = (float)std::max(lastShotFirstFrame, frameRing->getFirst());
+    int speed = 2;
+    bool exit = false;
+
+    tickLoop([&]() {
+        form->tick(false, [&](Form::event_args_t e) {
+            if (e.type == Form::KEY) {
+                switch (e.record.wVirtualKeyCode) {
+                case VK_ESCAPE:
+                case VK_A - 'A' + 'R':
+                    exit = true;
+                    break;
+                case VK_UP:
+                    speed = std::min(speed + 1, NUM_SPEEDS - 1);
+                    break;
+                case VK_DOWN:
+                    speed = std::max(speed - 1, 0);
+                    break;
+                case VK_SPACE:
+                    position = (float)std::max(lastShotFirstFrame, frameRing->getFirst());
+                    break;
+                }
+            }
+        });
+        position = std::min(position + SPEEDS[speed], (float)lastFrame);
+    }, [&]()->bool {
+        if (exit)
+            return false;
+
+        const uint64_t frame = std::max((uint64_t)position, frameRing->getFirst());
+        const DoublePixelBufferedConsole *canvas = frameRing->get(frame);
+        if (canvas)
+            canvas->commit(*mainRegion);
+
+        std::ostringstream text;
+        text << "Instant replay - " << SPEEDS[speed] << "x, up and down to change speed";
+        if (frame >= lastFrame)
+            text << ", space to watch again";
+        topRegion->clear(WHITE);
+        printText(topRegion.get(), 0, 0, topRegion->width, 1, text.str(), BLACK, CENTER, false);
+
+        console->commit();
+        return true;
+    }, match->ticksPerSecond);
 }
 
 static bool gameGlobalAction(Form::event_args_t e) {
     if (e.type == Form::KEY) {
-        switch (e.record.wVirtualKeyCode) {
-        case VK_ESCAPE:
+        const WORD key = e.record.wVirtualKeyCode;
+        if (replayPlayer) {
+            switch (key) {
+            case VK_LEFT:
+            case VK_RIGHT: {
+                std::lock_guard<std::mutex> lock(matchMutex);
+                const uint64_t seekTicks = 10 * match->ticksPerSecond;
+                const uint64_t tick = match->tickNumber;
+                if (key == VK_LEFT)
+                    seekReplay(tick > seekTicks ? tick - seekTicks : 0);
+                else
+                    seekReplay(tick + seekTicks);
+                return true;
+            }
+            case VK_ESCAPE:
+            case VK_A - 'A' + 'C':
+            case VK_A - 'A' + 'F':
+            case VK_A - 'A' + 'P':
+            case VK_A - 'A' + 'R':
+            case VK_A - 'A' + 'T':
+                break;
+            default:
+                // a replay only takes commands from the recording
+                return false;
+            }
+        }
+
+        // menus pause the match by holding matchMutex until they close, so does anything else
+        // that reads or changes the match rather than asking the simulation to
+        switch (key) {
+        case VK_ESCAPE: {
+            std::lock_guard<std::mutex> lock(matchMutex);
             callWithConsoleSnapshot(pauseScreen);
             return true;
+        }
         case VK_A - 'A' + 'W':
             e.record.wVirtualKeyCode = VK_UP;
             return powerAreaAction(e);
@@ -1003,6 +1192,49 @@ static bool gameGlobalAction(Form::event_args_t e) {
         case VK_A - 'A' + 'D':
             e.record.wVirtualKeyCode = VK_RIGHT;
             return angleAreaAction(e);
+        case VK_A - 'A' + 'T': {
+            std::lock_guard<std::mutex> lock(matchMutex);
+            match->showShotPreview = !match->showShotPreview;
+            return true;
+        }
+        case VK_A - 'A' + 'R':
+            if (hasLastShot && frameRing->contains(lastShotLastFrame)) {
+                std::lock_guard<std::mutex> lock(matchMutex);
+                callWithConsoleSnapshot(instantReplayScreen);
+            }
+            return true;
+        case VK_A - 'A' + 'F':
+            fastForward = !fastForward;
+            return true;
+        case VK_A - 'A' + 'P': {
+            if (!Profiler::ENABLED)
+                break;
+
+            std::lock_guard<std::mutex> lock(matchMutex);
+            std::ofstream trace("profile.json");
+            Profiler::writeChromeTrace(trace);
+            std::ofstream csv("profile.csv");
+            Profiler::writeCsv(csv);
+            saveStatus = trace && csv ? "Profile written" : "Couldn't write the profile";
+            saveStatusTime = GetTickCount64();
+            return true;
+        }
+        case VK_A - 'A' + 'C': {
+            std::lock_guard<std::mutex> lock(matchMutex);
+            // only matches built from a setup have a seed code
+            std::shared_ptr<const Replay> replay = replayPlayer ? replayPlayer->getReplay() :
+                match->recording;
+            if (replay) {
+                try {
+                    copyToClipboard(replay->setup.toCode());
+                    saveStatus = "Seed code copied";
+                    saveStatusTime = GetTickCount64();
+                } catch (std::exception &error) {
+                    messageBox(error.what(), "Error while copying seed code");
+                }
+            }
+            return true;
+        }
         }
     }
 
@@ -1024,15 +1256,227 @@ const char *PLAYER_TEAM_NAMES[] = {
     "Yellow"
 };
 
+static std::string getGameOverText() {
+    for (int i = 0; i < match->players.size(); i++)
+        if (match->players[i]->tank->alive)
+            return std::string(PLAYER_TEAM_NAMES[match->players[i]->team]) + " won!";
+    return "";
+}
+
+// the line above the match, taken along with the copy of the match it's drawn with
+static std::string getStatusText(const FramePacer &pacer) {
+    // always on in profiling and instrumented builds, along with what they measured
+    static const bool SHOW_TICKS = Profiler::ENABLED || Instrumentation::ENABLED;
+    static const ULONGLONG SAVE_STATUS_MS = 2000;
+
+    std::ostringstream tickCounterText;
+    if (match->gameOver)
+        tickCounterText << getGameOverText();
+    else if (replayPlayer)
+        tickCounterText << (replayPlayer->isFinished() ? "Replay over" : "Replay") << " - " <<
+            match->tickNumber / match->ticksPerSecond << "s of " <<
+            replayPlayer->getEndTick() / match->ticksPerSecond << "s, left and right to seek";
+    else if (match->isAiming && !match->players[match->currentPlayer]->isHuman)
+        tickCounterText << "Bot thinking";
+    if (replayPlayer && replayPlayer->isDesynced()) {
+        if (tickCounterText.str().size())
+            tickCounterText << " - ";
+        tickCounterText << "out of sync since tick " << replayPlayer->getDesyncTick();
+    }
+    if (fastForward) {
+        if (tickCounterText.str().size())
+            tickCounterText << " - ";
+        tickCounterText << "Fast forward";
+    }
+    if (pendingSave.valid() || GetTickCount64() - saveStatusTime < SAVE_STATUS_MS) {
+        if (tickCounterText.str().size())
+            tickCounterText << " - ";
+        tickCounterText << (pendingSave.valid() ? "Saving..." : saveStatus);
+    }
+    if (SHOW_TICKS) {
+        if (tickCounterText.str().size())
+            tickCounterText << " - ";
+        tickCounterText << "Tick " << match->tickNumber << ", " << pacer.getDroppedTicks() <<
+            " dropped, jitter " <<
+            std::chrono::duration_cast<std::chrono::microseconds>(pacer.getAverageJitter()).count() <<
+            "us avg " <<
+            std::chrono::duration_cast<std::chrono::microseconds>(pacer.getMaxJitter()).count() <<
+            "us max";
+        if (Profiler::ENABLED) {
+            tickCounterText << " - us";
+            for (int i = 0; i < Profiler::NUM_SECTIONS; i++) {
+                const Profiler::clock_t::duration time =
+                    Profiler::getLastFrame((Profiler::Section)i);
+                if (time > Profiler::clock_t::duration::zero())
+                    tickCounterText << " " << Profiler::SECTION_NAMES[i] << " " <<
+                        std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+            }
+        }
+        tickCounterText << " - ticks " << tickLatency.getSummary();
+        if (match->degradation > TankMatch::DEGRADE_NONE)
+            tickCounterText << " - degraded " << match->degradation;
+        if (Instrumentation::ENABLED) {
+            const Instrumentation::tick_t &tick = match->lastTick;
+            tickCounterText << " - " << tick.counters.allocations << " allocs " <<
+                tick.counters.bytes << "B, entities +" << tick.counters.entitiesAdded << " -" <<
+                tick.counters.entitiesRemoved;
+            for (const std::pair<const std::type_index, int> &type : tick.liveEntities)
+                if (type.second)
+                    tickCounterText << " " << Instrumentation::getTypeName(type.first) << " " <<
+                        type.second;
+        }
+    }
+
+    return tickCounterText.str();
+}
+
+// draws a tick from the copy of the match taken for it, without holding matchMutex
+static void drawGame(BufferedConsole &frame, TankMatch &view, TextBox &tickCounter,
+    const std::string &status) {
+    std::shared_ptr<BufferedConsoleRegion> mainRegion = BufferedConsoleRegion::create(frame,
+        view.width, view.height / 2, 1, 2);
+
+    frame.clear(WHITE);
+
+    view.draw(*mainRegion);
+
+    HILLTOP_PROFILE_SCOPE(Profiler::UI_DRAW);
+    tickCounter.text = status;
+    tickCounter.draw(frame);
+}
+
+// keeps a frame the simulation just handed over for the instant replay, before anything is drawn
+// over it
+static void recordFrame(const TankMatch &shown) {
+    const uint64_t frameNumber = frameRing->push(shown.canvas);
+    if (!shown.isAiming && !shotInProgress) {
+        shotInProgress = true;
+        lastShotFirstFrame = frameNumber;
+    } else if (shown.isAiming && shotInProgress) {
+        shotInProgress = false;
+        hasLastShot = true;
+        lastShotLastFrame = frameNumber;
+    }
+}
+
+// the controls, drawn by the input thread they belong to over the match as it was last shown
+static void drawGameUI(BufferedConsole &console, const TankMatch &shown) {
+    HILLTOP_PROFILE_SCOPE(Profiler::UI_DRAW);
+    gameFormUpdate(shown);
+
+    bottomArea->draw(console);
+    weaponAreaDraw(console, shown);
+
+    if (!replayPlayer && shown.isAiming && shown.players[shown.currentPlayer]->isHuman) {
+        gameForm->draw(console, *bottomArea);
+        if (gameForm->currentPos == WEAPON_AREA && gameForm->isFocused)
+            drawWeaponList(console, shown);
+    }
+}
+
+// the entities by type, and whatever else was going on, see writeSlowTicks()
+static void logSlowTick(FramePacer::clock_t::duration took) {
+    std::map<std::string, int> census;
+    for (const std::shared_ptr<Entity> &p : match->entities)
+        census[Instrumentation::getTypeName(typeid(*p))]++;
+
+    std::ostringstream log;
+    log << "tick " << match->tickNumber << " took " <<
+        std::chrono::duration<double, std::milli>(took).count() << "ms of " <<
+        std::chrono::duration<double, std::milli>(getTickPeriod(match->ticksPerSecond)).count() <<
+        "ms with " << match->entities.size() << " entities:";
+    for (const std::pair<const std::string, int> &type : census)
+        log << " " << type.first << " " << type.second;
+
+    log << ", running:";
+    if (replayPlayer)
+        log << " replay";
+    if (!match->isAiming)
+        log << " shot";
+    else if (!match->players[match->currentPlayer]->isHuman)
+        log << " bot";
+    if (fastForward)
+        log << " fast forward";
+    for (int i = 0; i < Profiler::NUM_SECTIONS; i++) {
+        const Profiler::clock_t::duration time = Profiler::getCurrentFrame((Profiler::Section)i);
+        if (time > Profiler::clock_t::duration::zero())
+            log << " " << Profiler::SECTION_NAMES[i] << " " <<
+                std::chrono::duration_cast<std::chrono::microseconds>(time).count() << "us";
+    }
+    log << "\n";
+    slowTickLog += log.str();
+}
+
+// called by the simulation thread without matchMutex held, so the file is never written mid-tick
+static void writeSlowTicks() {
+    if (slowTickLog.empty())
+        return;
+
+    std::ofstream log(LATENCY_LOG_FILENAME, std::ios::app);
+    log << slowTickLog;
+    slowTickLog.clear();
+}
+
+static void logLatencySummary() {
+    if (tickLatency.getCount() == 0)
+        return;
+
+    std::ofstream log(LATENCY_LOG_FILENAME, std::ios::app);
+    log << "match of " << tickLatency.getCount() << " ticks, " << match->ticksPerSecond <<
+        " per second: ticks " << tickLatency.getSummary() << ", frames " <<
+        frameLatency.getSummary() << "\n";
+}
+
+static void stepMatch() {
+    if (!replayPlayer && match->gameOver)
+        return;
+
+    const FramePacer::clock_t::time_point start = FramePacer::clock_t::now();
+    if (replayPlayer)
+        replayPlayer->step();
+    else
+        match->tick();
+    const FramePacer::clock_t::duration took = FramePacer::clock_t::now() - start;
+
+    tickLatency.record(took);
+    if (LOG_SLOW_TICKS && took > getTickPeriod(match->ticksPerSecond))
+        logSlowTick(took);
+}
+
+// while fast forwarding, replays run to the end and bot turns run until someone human is up, but
+// not while a bot is still thinking, which would only add idle ticks
+static bool canFastForward() {
+    if (!fastForward || match->gameOver)
+        return false;
+    if (replayPlayer)
+        return !replayPlayer->isFinished();
+
+    const TankController &player = *match->players[match->currentPlayer];
+    return !player.isHuman && !player.isBotThinking();
+}
+
+// moves the match along between ticks: bots aim and fire, and turns end once everything settles
+static void advanceTurn() {
+    if (match->gameOver || replayPlayer) {
+        // the recording already has every shot and every turn change in it
+    } else if (match->isAiming) {
+        if (!match->players[match->currentPlayer]->isHuman) {
+            if (TankController::applyAI(match.get(), *match->players[match->currentPlayer]))
+                match->doCommand({ TankMatch::COMMAND_FIRE, 0 });
+        }
+    } else if (!match->recentUpdatesMattered()) {
+        match->doCommand({ TankMatch::COMMAND_END_TURN, 0 });
+        if (!match->gameOver)
+            autosaveGame();
+    }
+}
+
 static void gameLoop() {
-    static const bool SHOW_TICKS = false;
+    static const size_t FRAME_RING_BUDGET = 2 * 1024 * 1024;
 
     console = WindowsConsole::create(GetStdHandle(STD_OUTPUT_HANDLE), match->width + 4,
         match->height / 2 + 15);
 
-    std::shared_ptr<BufferedConsoleRegion> mainRegion = BufferedConsoleRegion::create(*console,
-        match->width, match->height / 2, 1, 2);
-
     std::shared_ptr<TextBox> tickCounter = TextBox::create();
     tickCounter->x = tickCounter->y = 0;
     tickCounter->width = match->width + 4;
@@ -1078,102 +1522,191 @@ static void gameLoop() {
     gameForm->actions[ANGLE_AREA] = angleAreaAction;
     gameForm->actions[POWER_AREA] = powerAreaAction;
     gameForm->currentPos = FIRE_BUTTON_TOP;
-    
-    tickLoop([&]() {
-        if (!match->gameOver) {
-            match->tick();
-            gameForm->tick(match->isAiming && match->players[match->currentPlayer]->isHuman,
-                gameGlobalAction);
-        } else {
-            gameForm->tick(false, gameGlobalAction);
-        }
-    }, [&]()->bool {
-        if (exitMatch) {
-            exitMatch = false;
-            return false;
-        }
-
-        console->clear(WHITE);
-
-        match->draw(*mainRegion);
 
-        std::string gameOverText;
-        if (match->gameOver) {
-            for (int i = 0; i < match->players.size(); i++) {
-                if (match->players[i]->tank->alive) {
-                    gameOverText = PLAYER_TEAM_NAMES[match->players[i]->team];
-                    gameOverText += " won!";
-                    break;
+    frameRing = std::make_shared<FrameRing>(match->canvas.width, match->canvas.height,
+        FRAME_RING_BUDGET);
+    shotInProgress = false;
+    hasLastShot = false;
+    tickLatency.reset();
+    frameLatency.reset();
+
+    // what the simulation hands over after drawing a tick, with the copy of the match it was drawn
+    // from, to draw the controls over and the match again at the frames shown before the next one
+    struct frame_t {
+        std::shared_ptr<MemoryConsole> console;
+        std::shared_ptr<TankMatch> view;
+        std::string status;
+        FramePacer::clock_t::time_point time;
+        bool interpolate;
+    };
+    const unsigned short matchWidth = match->width;
+    const unsigned short matchHeight = match->height;
+    auto createFrame = [matchWidth, matchHeight]()->frame_t {
+        return { MemoryConsole::create(console->width, console->height),
+            std::make_shared<TankMatch>(matchWidth, matchHeight), std::string(),
+            FramePacer::clock_t::time_point(), false };
+    };
+    const FramePacer::clock_t::duration tickPeriod = getTickPeriod(match->ticksPerSecond);
+
+    // the match runs on a thread of its own, so a slow console never holds up the simulation;
+    // this thread only reads input and shows the frames it draws, with the controls over them
+    TripleBuffer<frame_t> frames(createFrame(), createFrame(), createFrame());
+    // only changed with matchMutex held, so the match is never ticked again once this is set
+    bool stopSimulation = false;
+    std::atomic<bool> simulationStopped(false);
+    std::exception_ptr simulationError;
+
+    std::thread simulation([&]() {
+        // the rest of every frame is left for input and for drawing
+        static const int FAST_FORWARD_SHARE_PERCENT = 75;
+
+        FramePacer pacer(tickPeriod, MAX_CATCH_UP_TICKS);
+        // drawing happens after the lock is let go, so the match only learns how long it took at
+        // the next tick
+        std::chrono::steady_clock::duration drawTime = std::chrono::steady_clock::duration::zero();
+
+        try {
+            while (true) {
+                int ticks = pacer.wait();
+                frame_t &frame = frames.getBack();
+
+                {
+                    const FramePacer::clock_t::time_point beforeLock = FramePacer::clock_t::now();
+                    std::lock_guard<std::mutex> lock(matchMutex);
+                    if (stopSimulation)
+                        break;
+                    // the match may already have been swapped for another one that is about to
+                    // start
+                    if (exitMatch)
+                        continue;
+                    // held up by a menu or a message box, which pause the match, not slow ticks
+                    if (FramePacer::clock_t::now() - beforeLock > pacer.getPeriod())
+                        pacer.reset();
+
+                    // also covers matches loaded or seeked to since the last tick
+                    match->entityBudget = entityBudget;
+                    match->tickTimeBudgetPercent = tickTimeBudgetPercent;
+                    match->setDrawTime(drawTime);
+                    applyInput();
+
+                    const bool fastForwarding = canFastForward();
+                    if (fastForwarding) {
+                        // ticks back to back for most of a frame, then shows where the match
+                        // got to
+                        const FramePacer::clock_t::time_point until =
+                            FramePacer::clock_t::now() +
+                            pacer.getPeriod() * FAST_FORWARD_SHARE_PERCENT / 100;
+                        do {
+                            stepMatch();
+                            advanceTurn();
+                        } while (canFastForward() && FramePacer::clock_t::now() < until);
+                    } else {
+                        while (ticks--)
+                            stepMatch();
+                    }
+
+                    Profiler::endFrame();
+                    match->copyForDrawing(*frame.view);
+                    frame.interpolate = match->movedLastTick();
+                    frame.status = getStatusText(pacer);
+
+                    if (!fastForwarding)
+                        advanceTurn();
                 }
-            }
-        }
 
-        std::ostringstream tickCounterText;
-        if (match->gameOver)
-            tickCounterText << gameOverText;
-        else if (match->isAiming && !match->players[match->currentPlayer]->isHuman)
-            tickCounterText << "Bot thinking";
-        if (SHOW_TICKS) {
-            if (tickCounterText.str().size())
-                tickCounterText << " - ";
-            tickCounterText << "Tick " << match->tickNumber;
+                const std::chrono::steady_clock::time_point start =
+                    std::chrono::steady_clock::now();
+                drawGame(*frame.console, *frame.view, *tickCounter, frame.status);
+                drawTime = std::chrono::steady_clock::now() - start;
+                frame.time = FramePacer::clock_t::now();
+                frames.publish();
+                writeSlowTicks();
+            }
+        } catch (...) {
+            // shown the same way as an error on this thread would be, once the game loop exits
+            simulationError = std::current_exception();
         }
-        tickCounter->text = tickCounterText.str();
-        tickCounter->draw(*console);
-
-        gameFormUpdate();
+        writeSlowTicks();
+        simulationStopped = true;
+    });
 
-        bottomArea->draw(*console);
-        weaponAreaDraw();
+    // input is read at the rate of every other menu, the form's blinking counts on it
+    static const int FRAMES_PER_INPUT_TICK = DISPLAY_FRAMES_PER_SEC / GAME_TICKS_PER_SEC;
+    int frameCount = 0;
+    bool shownTick = true;
 
-        if (match->isAiming && match->players[match->currentPlayer]->isHuman) {
-            gameForm->draw(*console, *bottomArea);
-            if (gameForm->currentPos == WEAPON_AREA && gameForm->isFocused)
-                drawWeaponList();
-        }
-
-        console->commit();
-        
-        if (match->gameOver) {
-            if (!match->shownGameOver) {
-                messageBox(gameOverText, "Game over");
-                match->shownGameOver = true;
-            }
-        } else if (match->isAiming) {
-            if (!match->players[match->currentPlayer]->isHuman) {
-                match->isAiming = !TankController::applyAI(match.get(),
-                    *match->players[match->currentPlayer]);
-                if (!match->isAiming)
-                    match->fire();
+    try {
+        tickLoop([&]() {
+            if (frameCount++ % FRAMES_PER_INPUT_TICK != 0)
+                return;
+
+            // the controls go by the match as it was last shown, what they do is queued for the
+            // simulation
+            const TankMatch &shown = *frames.getFront().view;
+            gameForm->tick(!replayPlayer && !shown.gameOver && shown.isAiming &&
+                !shown.players.empty() && shown.players[shown.currentPlayer]->isHuman,
+                gameGlobalAction);
+        }, [&]()->bool {
+            // only ever set on this thread
+            if (exitMatch || simulationStopped) {
+                std::lock_guard<std::mutex> lock(matchMutex);
+                exitMatch = false;
+                stopSimulation = true;
+                return false;
             }
-        } else if (!match->isAiming && !match->recentUpdatesMattered()) {
-            for (int i = 0; i < match->players.size(); i++) {
-                std::shared_ptr<TankController> player = match->players[i];
-                if (player->weapons[player->currentWeapon].second <= 0) {
-                    player->weapons.erase(player->weapons.begin() + player->currentWeapon);
-                    player->currentWeapon = 0;
-                }
-                if (player->getWeaponCount() <= MIN_WEAPONS) {
-                    while (player->getWeaponCount() < START_WEAPONS)
-                        player->addRandomWeapon();
+
+            {
+                // never waits for a tick to finish, it's tried again at the next frame
+                std::unique_lock<std::mutex> lock(matchMutex, std::try_to_lock);
+                if (lock.owns_lock()) {
+                    finishSave(false);
+                    if (match->gameOver && !match->shownGameOver) {
+                        messageBox(getGameOverText(), "Game over");
+                        match->shownGameOver = true;
+                    }
                 }
             }
 
-            int nextPlayer = match->getNextPlayer();
-            if (nextPlayer >= 0) {
-                match->currentPlayer = nextPlayer;
-                match->players[match->currentPlayer]->movesLeft =
-                    match->players[match->currentPlayer]->movesPerTurn;
-                match->isAiming = true;
-                if (rand() % TankMatch::AIRDROP_EVERY_TURNS == 0)
-                    match->doAirdrop();
-            } else {
-                match->gameOver = true;
+            const bool fresh = frames.update();
+            const frame_t &frame = frames.getFront();
+            if (!fresh && (shownTick || !frame.interpolate))
+                return true;
+            if (fresh)
+                recordFrame(*frame.view);
+
+            // the latest tick is shown a tick late, after moving there from the one before it
+            const FramePacer::clock_t::time_point start = FramePacer::clock_t::now();
+            const float alpha = std::chrono::duration<float>(start - frame.time) /
+                std::chrono::duration<float>(tickPeriod);
+            frame.console->copyTo(*console);
+            shownTick = !frame.interpolate || alpha >= 1.0f;
+            if (!shownTick) {
+                std::shared_ptr<BufferedConsoleRegion> region = BufferedConsoleRegion::create(
+                    *console, matchWidth, matchHeight / 2, 1, 2);
+                frame.view->draw(*region, alpha);
             }
+            drawGameUI(*console, *frame.view);
+
+            {
+                HILLTOP_PROFILE_SCOPE(Profiler::COMMIT);
+                console->commit();
+            }
+            frameLatency.record(FramePacer::clock_t::now() - start);
+            return true;
+        }, DISPLAY_FRAMES_PER_SEC);
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(matchMutex);
+            stopSimulation = true;
         }
+        simulation.join();
+        throw;
+    }
 
-        return true;
-    });
+    simulation.join();
+    logLatencySummary();
+    if (simulationError)
+        std::rethrow_exception(simulationError);
 }
 
 static void drawMainMenuBackground(BufferedConsole &console) {
@@ -1231,13 +1764,15 @@ enum BotDifficulty {
     BOT_EASY = 0,
     BOT_MEDIUM,
     BOT_HARD,
+    BOT_HARD_PLUS,
     NUM_BOT_DIFFICULTIES
 };
 
 const char *BOT_DIFFICULTY_NAMES[] = {
     "Easy",
     "Medium",
-    "Hard"
+    "Hard",
+    "Hard+"
 };
 
 enum TankAttribute {
@@ -1260,12 +1795,6 @@ const char *TANK_ATTRIBUTE_NAMES[] = {
     "Armor"
 };
 
-enum MapType {
-    MAP_RANDOM,
-    MAP_HILLSIDE,
-    MAP_HILLTOP
-};
-
 const char *MAP_TYPE_NAMES[] = {
     "Random",
     "Hillside",
@@ -1278,6 +1807,18 @@ const char *FIRING_MODE_NAMES[] = {
     "Everyone"
 };
 
+const int TICK_RATES[] = {
+    TankMatch::MIN_TICKS_PER_SECOND,
+    TankMatch::DEFAULT_TICKS_PER_SECOND,
+    TankMatch::MAX_TICKS_PER_SECOND
+};
+
+const char *TICK_RATE_NAMES[] = {
+    "5/s",
+    "20/s",
+    "60/s"
+};
+
 struct {
     struct {
         bool enabled = false;
@@ -1286,8 +1827,10 @@ struct {
         int team;
         int tank[NUM_TANK_ATTRIBUTES];
     } players[4];
-    MapType mapType = MAP_HILLSIDE;
+    MatchSetup::MapType mapType = MatchSetup::MAP_HILLSIDE;
     TankMatch::FiringMode firingMode = TankMatch::FIRE_AS_TEAM;
+    // into TICK_RATES
+    int tickRate = 1;
 } newGameSettings;
 
 int activeTankAttribute = 0;
@@ -1450,20 +1993,23 @@ static void customizeTankMenu(int index) {
     });
 }
 
-std::shared_ptr<TextBox> gameOptionLabels[2];
-std::shared_ptr<TextBox> gameOptionOptions[6];
+std::shared_ptr<TextBox> gameOptionLabels[3];
+std::shared_ptr<TextBox> gameOptionOptions[9];
 
 static void updateGameOptionMenu() {
-    for (int i = 0; i < 2; i++) {
+    for (int i = 0; i < 3; i++) {
         for (int j = 0; j < 3; j++) {
             const int idx = i * 3 + j;
             ConsoleColor color = DARK_GRAY;
             if (i == 0) {
                 if (j == newGameSettings.mapType)
                     color = WHITE;
-            } else {
+            } else if (i == 1) {
                 if (j == newGameSettings.firingMode)
                     color = WHITE;
+            } else {
+                if (j == newGameSettings.tickRate)
+                    color = WHITE;
             }
             gameOptionOptions[idx]->color = color;
         }
@@ -1479,7 +2025,7 @@ static void gameOptionsMenu() {
     gameOptions->backgroundColor = DARK_BLUE;
     gameOptions->drawBackground = true;
 
-    for (int i = 0; i < 2; i++) {
+    for (int i = 0; i < 3; i++) {
         gameOptionLabels[i] = TextBox::create();
         gameOptionLabels[i]->width = 12;
         gameOptionLabels[i]->height = 1;
@@ -1489,8 +2035,10 @@ static void gameOptionsMenu() {
         gameOptionLabels[i]->alignment = RIGHT;
         if (i == 0)
             gameOptionLabels[i]->text = "Map Type";
-        else
+        else if (i == 1)
             gameOptionLabels[i]->text = "Firing Mode";
+        else
+            gameOptionLabels[i]->text = "Tick Rate";
         gameOptionLabels[i]->text += ":";
         gameOptions->addChild(*gameOptionLabels[i]);
 
@@ -1505,25 +2053,29 @@ static void gameOptionsMenu() {
             gameOptionOptions[idx]->alignment = CENTER;
             if (i == 0)
                 gameOptionOptions[idx]->text = MAP_TYPE_NAMES[j];
-            else
+            else if (i == 1)
                 gameOptionOptions[idx]->text = FIRING_MODE_NAMES[j];
+            else
+                gameOptionOptions[idx]->text = TICK_RATE_NAMES[j];
             gameOptions->addChild(*gameOptionOptions[idx]);
         }
     }
 
-    std::shared_ptr<Form> gameOptionsForm = std::make_shared<Form>(6);
-    for (int i = 0; i < 6; i++)
+    std::shared_ptr<Form> gameOptionsForm = std::make_shared<Form>(9);
+    for (int i = 0; i < 9; i++)
         gameOptionsForm->elements[i] = gameOptionOptions[i];
-    Form::configureMatrixForm(*gameOptionsForm, 2, 3);
-    for (int i = 0; i < 6; i++) {
+    Form::configureMatrixForm(*gameOptionsForm, 3, 3);
+    for (int i = 0; i < 9; i++) {
         gameOptionsForm->actions[i] = [](Form::event_args_t e)->bool {
             int row = e.position / 3;
             int col = e.position % 3;
 
             if (row == 0) {
-                newGameSettings.mapType = (MapType)col;
-            } else {
+                newGameSettings.mapType = (MatchSetup::MapType)col;
+            } else if (row == 1) {
                 newGameSettings.firingMode = (TankMatch::FiringMode)col;
+            } else {
+                newGameSettings.tickRate = col;
             }
 
             e.form->isFocused = false;
@@ -1599,95 +2151,56 @@ static void runGameLoop() {
     } while (reenterMatch);
 }
 
+static void startMatch(const MatchSetup &setup) {
+    match = setup.build();
+    match->recording = std::make_shared<Replay>(setup);
+    replayPlayer.reset();
+
+    runGameLoop();
+}
+
 static bool startGameAction(Form::event_args_t e) {
     if (newGameValid()) {
         exitNewGame = true;
 
-        match = std::make_shared<TankMatch>();
-
-        std::function<float(float)> invert = [](float x)->float { return x; };
-        if (scale((float)rand(), 0, RAND_MAX, 0, 1) >= 0.5f)
-            invert = [](float x)->float { return 1.0f - x; };
-
-        switch (newGameSettings.mapType) {
-        case MAP_RANDOM: {
-            float f[4];
-            for (int i = 0; i < 4; i++)
-                f[i] = scale((float)rand(), 0, RAND_MAX, 1.0f, 10.0f);
-            float a[4];
-            for (int i = 0; i < 4; i++)
-                a[i] = scale((float)rand(), 0, RAND_MAX, -1 / f[i], 1 / f[i]);
-            float o[4];
-            for (int i = 0; i < 4; i++)
-                o[i] = scale((float)rand(), 0, RAND_MAX, 0.0f, 6.28f);
-            match->buildMap([invert, &f, &a, &o](float x)->float {
-                float ret = 0;
-                for (int i = 0; i < 4; i++)
-                    ret += a[i] * std::sinf(f[i] * invert(x) + o[i]);
-                return 0.5f + ret;
-            });
-            break;
-        }
-        case MAP_HILLSIDE:
-            match->buildMap([invert](float x)->float {
-                return (std::sinf(invert(x) * 2 - 1.4f) + 1.0f) / 2.0f + 0.1f;
-            });
-            break;
-        case MAP_HILLTOP:
-            match->buildMap([invert](float x)->float {
-                return (std::sinf(invert(x) * 2) + 0.1f) / 1.5f + 0.1f;
-            });
-            break;
-        }
+        MatchSetup setup;
+        setup.seed = std::random_device()();
+        setup.mapType = newGameSettings.mapType;
+        setup.firingMode = newGameSettings.firingMode;
+        setup.ticksPerSecond = TICK_RATES[newGameSettings.tickRate];
 
         for (int i = 0; i < 4; i++) {
             if (newGameSettings.players[i].enabled) {
-                ConsoleColor color = BLACK;
+                MatchSetup::player_t player;
                 switch (newGameSettings.players[i].team) {
                 case TEAM_BLUE:
-                    color = BLUE;
+                    player.color = BLUE;
                     break;
                 case TEAM_GREEN:
-                    color = GREEN;
+                    player.color = GREEN;
                     break;
                 case TEAM_RED:
-                    color = RED;
+                    player.color = RED;
                     break;
                 case TEAM_YELLOW:
-                    color = YELLOW;
+                    player.color = YELLOW;
                     break;
                 }
 
-                std::shared_ptr<Tank> tank = Tank::create(color);
-                tank->maxHealth = 60 + 10 * newGameSettings.players[i].tank[TANK_HEALTH];
-                tank->health = tank->maxHealth;
-                tank->damage = 0.6f + 0.1f * newGameSettings.players[i].tank[TANK_DAMAGE];
-                tank->maxArmor = (int)scale((float)newGameSettings.players[i].tank[TANK_ARMOR],
+                player.team = newGameSettings.players[i].team;
+                player.isHuman = newGameSettings.players[i].human;
+                player.botDifficulty = newGameSettings.players[i].difficulty;
+                player.maxHealth = 60 + 10 * newGameSettings.players[i].tank[TANK_HEALTH];
+                // a whole percentage, so that seed codes can store it as one
+                player.damage = (60 + 10 * newGameSettings.players[i].tank[TANK_DAMAGE]) / 100.0f;
+                player.maxArmor = (int)scale((float)newGameSettings.players[i].tank[TANK_ARMOR],
                     (float)MIN_TANK_ATTRIBUTE_VALUE, (float)MAX_TANK_ATTRIBUTE_VALUE, 0, 100);
-                tank->armor = tank->maxArmor;
-                match->addEntity(*tank);
-
-                std::shared_ptr<TankController> controller = TankController::create();
-                controller->tank = tank;
-                controller->isHuman = newGameSettings.players[i].human;
-                controller->botDifficulty = newGameSettings.players[i].difficulty;
-                controller->team = newGameSettings.players[i].team;
-                controller->movesPerTurn = 5 + 5 * newGameSettings.players[i].tank[TANK_STAMINA];
-                controller->movesLeft = controller->movesPerTurn;
-                match->players.push_back(controller);
-
-                for (int i = 0; i < START_WEAPONS; i++)
-                    controller->addRandomWeapon();
+                player.movesPerTurn = 5 + 5 * newGameSettings.players[i].tank[TANK_STAMINA];
+                setup.players.push_back(player);
             }
         }
 
-        match->isAiming = match->players[match->currentPlayer]->isHuman;
-
-        match->firingMode = newGameSettings.firingMode;
-
-        match->arrangeTanks();
-
-        runGameLoop();
+        startMatch(setup);
     }
 
     e.form->isFocused = false;
@@ -1748,6 +2261,15 @@ static void newGameMenu() {
     newGameStartText->color = WHITE;
     newGameMenu->addChild(*newGameStartText);
 
+    std::shared_ptr<TextBox> seedCodeText = TextBox::create();
+    seedCodeText->width = 16;
+    seedCodeText->height = 1;
+    seedCodeText->x = newGameStartText->x;
+    seedCodeText->y = 0;
+    seedCodeText->text = "Ctrl+V seed code";
+    seedCodeText->color = GRAY;
+    newGameMenu->addChild(*seedCodeText);
+
     std::shared_ptr<TextBox> gameOptions = TextBox::create();
     gameOptions->width = 12;
     gameOptions->height = 1;
@@ -1821,8 +2343,23 @@ static void newGameMenu() {
 
     tickLoop([&]() {
         newGameForm->tick(true, [&](Form::event_args_t e) {
-            if (e.type == Form::KEY && e.record.wVirtualKeyCode == VK_ESCAPE)
+            if (e.type != Form::KEY)
+                return;
+
+            if (e.record.wVirtualKeyCode == VK_ESCAPE) {
                 exitNewGame = true;
+            } else if (e.record.wVirtualKeyCode == VK_A - 'A' + 'V' &&
+                (e.record.dwControlKeyState & (LEFT_CTRL_PRESSED | RIGHT_CTRL_PRESSED))) {
+                MatchSetup setup;
+                try {
+                    setup = MatchSetup::fromCode(readClipboard());
+                } catch (std::exception &error) {
+                    messageBox(error.what(), "Error while reading seed code");
+                    return;
+                }
+                exitNewGame = true;
+                startMatch(setup);
+            }
         });
     }, [&]()->bool {
         if (exitNewGame) {
@@ -1866,6 +2403,7 @@ static bool loadGameAction(Form::event_args_t e) {
 }
 
 static bool weaponTestAction(Form::event_args_t e) {
+    replayPlayer.reset();
     match = std::make_shared<TankMatch>();
     match->buildMap([](float x) { return 0.5f; });
 
@@ -1956,11 +2494,71 @@ static void mainMenu() {
     });
 }
 
-int main() {
+// Hilltop.exe --benchmark [--json] [filter] times the scenarios in Game/Benchmark.cpp instead of
+// starting the game, and prints the results to the console it was run from
+static int runBenchmark(int argc, char **argv) {
+    bool json = false;
+    std::string filter;
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--json"))
+            json = true;
+        else
+            filter = argv[i];
+    }
+
+    try {
+        std::vector<Benchmark::result_t> results = Benchmark::run(filter);
+        if (json)
+            Benchmark::writeJson(std::cout, results);
+        else
+            Benchmark::writeText(std::cout, results);
+    } catch (std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Hilltop.exe [--entity-budget COUNT] [--tick-budget PERCENT] sets how many entities, and how much
+// of every tick period spent ticking and drawing, a match takes before it starts cutting back on
+// trails, for machines the defaults don't suit, see TankMatch::entityBudget
+static bool parseOptions(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const bool entities = !strcmp(argv[i], "--entity-budget");
+        const bool ticks = !strcmp(argv[i], "--tick-budget");
+        if (!entities && !ticks) {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return false;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << argv[i] << " needs a value" << std::endl;
+            return false;
+        }
+
+        char *end;
+        const long value = std::strtol(argv[++i], &end, 10);
+        if (*end || value < 1 || value > (ticks ? 100 : INT_MAX)) {
+            std::cerr << "Invalid value for " << argv[i - 1] << ": " << argv[i] << std::endl;
+            return false;
+        }
+        if (entities)
+            entityBudget = (int)value;
+        else
+            tickTimeBudgetPercent = (int)value;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
     srand(GetTickCount());
 
-    initWindowsColors();
     TankMatch::initalizeWeapons();
+    if (argc > 1 && !strcmp(argv[1], "--benchmark"))
+        return runBenchmark(argc, argv);
+    if (!parseOptions(argc, argv))
+        return 1;
+
+    initWindowsColors();
 
     newGameSettings.players[0].enabled = true;
     newGameSettings.players[0].human = true;